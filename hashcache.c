@@ -0,0 +1,387 @@
+/*
+    Bounded LRU Cache on an Open Addressing Hash Table
+    
+    Description:
+    A capacity-bounded cache with two eviction policies:
+
+    - HC_POLICY_LRU evicts the least recently used entry. The recency list is
+      intrusive: every slot of the open addressing array carries the indices of its
+      list neighbours, so there are no list nodes to allocate and no pointers to chase
+      outside the slot array. Every hit relinks the entry at the head of the list.
+    - HC_POLICY_CLOCK approximates LRU with a small reference counter per slot, kept in
+      its own byte array. A hit only increments the counter (saturating at
+      HC_CLOCK_MAX) with a relaxed atomic store, and only when it is not already
+      saturated, so hot entries stop generating writes altogether. Eviction sweeps a
+      hand over the slot array, decrementing counters until it finds an entry whose
+      counter is zero. Since lookups never modify the slots, the list or the hash
+      metadata, `ht_cache_get` may run concurrently from many threads holding a shared
+      (reader) lock; only puts and deletes need exclusive access.
+
+    - The slot array is sized once from the capacity so that the load factor never
+      exceeds the hash table's threshold. The cache never resizes.
+    - Deletion and eviction use backward-shift deletion instead of tombstones, so
+      probe sequences stay short no matter how much the cache churns. Shifted entries
+      have their list neighbours re-pointed at their new slot.
+    - LRU eviction unlinks the list tail, which is O(1) plus a short backward shift.
+      CLOCK eviction visits at most HC_CLOCK_MAX + 1 sweeps of the array and is O(1)
+      amortized.
+
+    Functions:
+    - Initialization (`ht_cache_init` for LRU, `ht_cache_init_policy` to choose the
+      policy) and cleanup (`ht_cache_free`).
+    - Insertion (`ht_cache_put`): inserts or updates an entry, marks it most recently
+      used and reports the evicted entry, if any.
+    - Lookup (`ht_cache_get`): returns the value and marks the entry as recently used.
+    - Lookup without touching recency (`ht_cache_peek`).
+    - Deletion (`ht_cache_delete`).
+    - Utility: maximum number of entries (`ht_cache_capacity`) and current number of
+      entries (`ht_cache_count`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashcache.h"
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define HC_FULL(tag) ((uint8_t)(0x80 | (tag)))
+#define HC_TAG(hash_value) ((uint8_t)((hash_value) >> 25))
+
+static size_t hc_find(HashCache *cache, const char *key, uint32_t hash_value) {
+    uint8_t tag = HC_FULL(HC_TAG(hash_value));
+    size_t index = hash_value % cache->size;
+
+    while(cache->meta[index] != HC_EMPTY) {
+        if(cache->meta[index] == tag && cache->slots[index].hash == hash_value &&
+           strcmp(cache->slots[index].key, key) == 0) {
+            return index;
+        }
+
+        index = (index + 1) % cache->size;
+    }
+
+    return SIZE_MAX;
+}
+
+static void hc_unlink(HashCache *cache, uint32_t index) {
+    HashCacheSlot *slot = &cache->slots[index];
+
+    if(slot->prev != HC_NIL) {
+        cache->slots[slot->prev].next = slot->next;
+    }
+    else {
+        cache->head = slot->next;
+    }
+
+    if(slot->next != HC_NIL) {
+        cache->slots[slot->next].prev = slot->prev;
+    }
+    else {
+        cache->tail = slot->prev;
+    }
+}
+
+static void hc_push_front(HashCache *cache, uint32_t index) {
+    HashCacheSlot *slot = &cache->slots[index];
+
+    slot->prev = HC_NIL;
+    slot->next = cache->head;
+
+    if(cache->head != HC_NIL) {
+        cache->slots[cache->head].prev = index;
+    }
+    else {
+        cache->tail = index;
+    }
+
+    cache->head = index;
+}
+
+static void hc_touch(HashCache *cache, uint32_t index) {
+    if(cache->policy == HC_POLICY_CLOCK) {
+        uint8_t ref = __atomic_load_n(&cache->refs[index], __ATOMIC_RELAXED);
+
+        // Saturated counters are left alone so that hot entries cause no writes
+        if(ref < HC_CLOCK_MAX) {
+            __atomic_store_n(&cache->refs[index], ref + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else if(cache->head != index) {
+        hc_unlink(cache, index);
+        hc_push_front(cache, index);
+    }
+}
+
+// Inserts the entry in slot index as the most recently used one
+static void hc_link_new(HashCache *cache, uint32_t index) {
+    if(cache->policy == HC_POLICY_CLOCK) {
+        cache->refs[index] = 0;
+    }
+    else {
+        hc_push_front(cache, index);
+    }
+}
+
+// Picks the slot to evict: the list tail, or the first unreferenced slot under the hand
+static uint32_t hc_victim(HashCache *cache) {
+    if(cache->policy == HC_POLICY_LRU) {
+        return cache->tail;
+    }
+
+    for(;;) {
+        size_t index = cache->hand;
+
+        cache->hand = (cache->hand + 1) % cache->size;
+
+        if(cache->meta[index] == HC_EMPTY) {
+            continue;
+        }
+
+        if(cache->refs[index] == 0) {
+            return (uint32_t)index;
+        }
+
+        cache->refs[index]--;
+    }
+}
+
+// Moves the entry in slot from into the empty slot to, keeping its list position
+static void hc_move(HashCache *cache, uint32_t from, uint32_t to) {
+    HashCacheSlot *slot = &cache->slots[to];
+
+    *slot = cache->slots[from];
+    cache->meta[to] = cache->meta[from];
+    cache->meta[from] = HC_EMPTY;
+
+    if(cache->policy == HC_POLICY_CLOCK) {
+        cache->refs[to] = cache->refs[from];
+        return;
+    }
+
+    if(slot->prev != HC_NIL) {
+        cache->slots[slot->prev].next = to;
+    }
+    else {
+        cache->head = to;
+    }
+
+    if(slot->next != HC_NIL) {
+        cache->slots[slot->next].prev = to;
+    }
+    else {
+        cache->tail = to;
+    }
+}
+
+// Removes the entry in slot index and closes the gap with backward-shift deletion
+static void hc_remove_slot(HashCache *cache, uint32_t index) {
+    if(cache->policy == HC_POLICY_LRU) {
+        hc_unlink(cache, index);
+    }
+
+    cache->meta[index] = HC_EMPTY;
+    cache->element_count--;
+
+    size_t hole = index;
+    size_t next = (hole + 1) % cache->size;
+
+    while(cache->meta[next] != HC_EMPTY) {
+        size_t home = cache->slots[next].hash % cache->size;
+
+        // The entry may fill the hole only if the hole lies on its probe path home..next
+        bool reachable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+
+        if(reachable) {
+            hc_move(cache, (uint32_t)next, (uint32_t)hole);
+            hole = next;
+        }
+
+        next = (next + 1) % cache->size;
+    }
+}
+
+bool ht_cache_put(HashCache *cache, const char *key, void *value, HashCacheEntry *evicted) {
+    if(evicted) {
+        evicted->key = NULL;
+        evicted->value = NULL;
+    }
+
+    if(!cache || cache->size == 0) {
+        fputs("Cannot put a value into an unallocated cache.\n", stderr);
+        return false;
+    }
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return false;
+    }
+    else if(*key == '\0') {
+        fputs("Key cannot be an empty string.\n", stderr);
+        return false;
+    }
+
+    uint32_t hash_value = ht_fnv1a(key);
+    size_t index = hc_find(cache, key, hash_value);
+
+    if(index != SIZE_MAX) {
+        cache->slots[index].value = value;
+        hc_touch(cache, (uint32_t)index);
+
+        return true;
+    }
+
+    if(cache->element_count == cache->capacity) {
+        uint32_t victim = hc_victim(cache);
+
+        if(evicted) {
+            evicted->key = cache->slots[victim].key;
+            evicted->value = cache->slots[victim].value;
+        }
+
+        hc_remove_slot(cache, victim);
+    }
+
+    index = hash_value % cache->size;
+
+    while(cache->meta[index] != HC_EMPTY) {
+        index = (index + 1) % cache->size;
+    }
+
+    HashCacheSlot *slot = &cache->slots[index];
+
+    cache->meta[index] = HC_FULL(HC_TAG(hash_value));
+    slot->key = key;
+    slot->value = value;
+    slot->hash = hash_value;
+    hc_link_new(cache, (uint32_t)index);
+    cache->element_count++;
+
+    return true;
+}
+
+bool ht_cache_get(HashCache *cache, const char *key, void **out) {
+    if(!cache || cache->element_count == 0 || !key || *key == '\0') {
+        return false;
+    }
+
+    size_t index = hc_find(cache, key, ht_fnv1a(key));
+
+    if(index == SIZE_MAX) {
+        return false;
+    }
+
+    hc_touch(cache, (uint32_t)index);
+
+    if(out) {
+        *out = cache->slots[index].value;
+    }
+
+    return true;
+}
+
+bool ht_cache_peek(HashCache *cache, const char *key, void **out) {
+    if(!cache || cache->element_count == 0 || !key || *key == '\0') {
+        return false;
+    }
+
+    size_t index = hc_find(cache, key, ht_fnv1a(key));
+
+    if(index == SIZE_MAX) {
+        return false;
+    }
+
+    if(out) {
+        *out = cache->slots[index].value;
+    }
+
+    return true;
+}
+
+void ht_cache_delete(HashCache *cache, const char *key) {
+    if(!cache || cache->element_count == 0 || !key || *key == '\0') {
+        return;
+    }
+
+    size_t index = hc_find(cache, key, ht_fnv1a(key));
+
+    if(index != SIZE_MAX) {
+        hc_remove_slot(cache, (uint32_t)index);
+    }
+}
+
+void ht_cache_free(HashCache **cache_ptr) {
+    if(!cache_ptr || !*cache_ptr) {
+        return;
+    }
+
+    HashCache *cache = *cache_ptr;
+
+    free(cache->meta);
+    free(cache->refs);
+    free(cache->slots);
+    free(cache);
+    *cache_ptr = NULL;
+}
+
+size_t ht_cache_capacity(HashCache *cache) {
+    if(!cache) {
+        fputs("Cache is NULL.\n", stderr);
+        return 0;
+    }
+
+    return cache->capacity;
+}
+
+size_t ht_cache_count(HashCache *cache) {
+    if(!cache) {
+        fputs("Cache is NULL.\n", stderr);
+        return 0;
+    }
+
+    return cache->element_count;
+}
+
+HashCache *ht_cache_init_policy(size_t capacity, HashCachePolicy policy) {
+    capacity = capacity == 0 ? 1 : capacity;
+
+    // Slot indices must fit the 32-bit list links, with HC_NIL reserved
+    if(capacity > (size_t)((double)(HC_NIL - 1) * LOAD_FACTOR_THRESHOLD)) {
+        fputs("Cache capacity is too large.\n", stderr);
+        return NULL;
+    }
+
+    HashCache *cache = malloc(sizeof(HashCache));
+
+    if(!cache) {
+        fputs("Cannot allocate a memory for cache struct.\n", stderr);
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+    cache->policy = policy;
+    cache->size = (size_t)((double)capacity / LOAD_FACTOR_THRESHOLD) + 1;
+    cache->element_count = 0;
+    cache->head = HC_NIL;
+    cache->tail = HC_NIL;
+    cache->hand = 0;
+    cache->meta = calloc(cache->size, sizeof(uint8_t));
+    cache->refs = policy == HC_POLICY_CLOCK ? calloc(cache->size, sizeof(uint8_t)) : NULL;
+    cache->slots = malloc(cache->size * sizeof(HashCacheSlot));
+
+    if(!cache->meta || !cache->slots || (policy == HC_POLICY_CLOCK && !cache->refs)) {
+        free(cache->meta);
+        free(cache->refs);
+        free(cache->slots);
+        free(cache);
+        fputs("Cannot allocate a memory for cache slots.\n", stderr);
+
+        return NULL;
+    }
+
+    return cache;
+}
+
+HashCache *ht_cache_init(size_t capacity) {
+    return ht_cache_init_policy(capacity, HC_POLICY_LRU);
+}
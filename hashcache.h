@@ -0,0 +1,53 @@
+#ifndef HASH_CACHE_H
+#define HASH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HC_EMPTY 0x00
+#define HC_NIL UINT32_MAX
+#define HC_CLOCK_MAX 3
+
+typedef enum {
+    HC_POLICY_LRU,   // exact LRU through the intrusive recency list
+    HC_POLICY_CLOCK  // approximate LRU through per-slot reference counters and a sweeping hand
+} HashCachePolicy;
+
+typedef struct {
+    const char *key;
+    void *value;
+    uint32_t hash;
+    uint32_t prev;  // neighbour towards the most recently used entry (LRU only)
+    uint32_t next;  // neighbour towards the least recently used entry (LRU only)
+} HashCacheSlot;
+
+typedef struct {
+    const char *key;
+    void *value;
+} HashCacheEntry;
+
+typedef struct HashCache {
+    size_t size;          // number of slots, fixed for the lifetime of the cache
+    size_t capacity;      // maximum number of entries
+    size_t element_count;
+    HashCachePolicy policy;
+    uint8_t *meta;        // HC_EMPTY or 0x80 | 7 bits of the key's hash
+    uint8_t *refs;        // per-slot reference counters, 0..HC_CLOCK_MAX (CLOCK only)
+    HashCacheSlot *slots;
+    uint32_t head;        // most recently used slot (LRU only)
+    uint32_t tail;        // least recently used slot (LRU only)
+    size_t hand;          // next slot the eviction sweep inspects (CLOCK only)
+} HashCache;
+
+bool ht_cache_put(HashCache *cache, const char *key, void *value, HashCacheEntry *evicted);
+bool ht_cache_get(HashCache *cache, const char *key, void **out);
+bool ht_cache_peek(HashCache *cache, const char *key, void **out);
+void ht_cache_delete(HashCache *cache, const char *key);
+void ht_cache_free(HashCache **cache_ptr);
+size_t ht_cache_capacity(HashCache *cache);
+size_t ht_cache_count(HashCache *cache);
+HashCache *ht_cache_init(size_t capacity);
+HashCache *ht_cache_init_policy(size_t capacity, HashCachePolicy policy);
+
+#endif
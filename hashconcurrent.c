@@ -0,0 +1,655 @@
+/*
+    Lock-Free Concurrent Hash Table with Cooperative Resizing
+
+    Description:
+    A hash table in which any number of threads insert, update, delete and look up
+    keys concurrently without locks. It follows the design of Cliff Click's
+    non-blocking hash map, adapted to the library's linear probing and FNV-1a hash.
+
+    - A slot has an atomic key and an atomic value word. A key is claimed once with a
+      CAS and never changes within an array, which keeps concurrent inserts of the same
+      key from landing in two slots. Deletion only changes the value word.
+    - The value word is one of: CH_NEVER (no value written yet), CH_TOMB (deleted),
+      CH_MOVED (migrated to the next array), a pointer to a box holding the user's
+      value, or such a pointer tagged with CH_PRIME (being migrated). Boxes are
+      immutable, so NULL is a legitimate value. A replaced box is freed through
+      epoch-based reclamation, which queues it on the writer's own thread.
+    - Boxes come from a per-thread cache instead of malloc. A thread whose cache runs
+      dry takes a batch of HT_BOX_BATCH free boxes from a shared depot, or carves a new
+      block; a thread that frees more than it allocates hands batches back, and an
+      exiting thread returns its whole cache. So the depot lock is taken once per batch
+      at most, and a write takes no lock at all. Box memory is kept for reuse for the
+      life of the process.
+    - When the claimed keys of an array exceed the load factor, a new array is
+      attached as its `next`. Every writer that meets an array with a `next` helps by
+      migrating one chunk of HT_MIGRATE_CHUNK slots, claimed with a fetch-and-add.
+      Before writing a key it also migrates that key's old slot itself. Migrating a
+      slot first primes its value, then copies it into the next array only if that
+      slot was never written there, and finally marks it CH_MOVED. So neither a newer
+      write nor a delete in the next array is overwritten.
+    - If a copy cannot allocate (its box, or an array to migrate into), the slot stays
+      primed, still readable in the old array, and the write that needed it fails.
+      Slots a chunk left primed are retried by the next helper once every chunk has
+      been claimed, so a migration finishes once memory is available again.
+    - Whoever marks a slot CH_MOVED counts it. Once every slot is counted, the next
+      array is promoted to the top with a CAS and the old one is retired. Readers
+      never help and never write shared memory.
+    - The element count is striped across cache lines, so `ht_concurrent_count` is
+      exact only when no writes are in flight.
+
+    Every function except `ht_concurrent_free` may be called from any thread.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashconcurrent.h"
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define CH_NEVER ((uintptr_t)0)
+#define CH_PRIME ((uintptr_t)1)
+#define CH_MOVED ((uintptr_t)2)
+#define CH_TOMB ((uintptr_t)4)
+#define CH_IS_BOX(v) ((v) > CH_TOMB)
+#define CH_BOX(v) ((void **)((v) & ~CH_PRIME))
+#define HT_MIGRATE_CHUNK 1024
+#define HT_BOX_BATCH 256
+
+typedef enum {
+    CH_PUT,     // store unconditionally
+    CH_COPY     // store only into a slot that has never been written (migration)
+} HashConcurrentMode;
+
+// A value box; while free, it links into a thread's cache or a depot batch
+typedef union HashBox {
+    void *value;                // first, so that a box is used as a void **
+    struct {
+        union HashBox *next;
+        union HashBox *next_batch;
+    } free;
+} HashBox;
+
+static pthread_mutex_t depot_lock = PTHREAD_MUTEX_INITIALIZER;
+static HashBox *depot = NULL;           // batches of free boxes
+static HashBox *box_blocks = NULL;      // every block ever carved, linked through its first box
+static pthread_key_t box_cache_key;
+static pthread_once_t box_cache_once = PTHREAD_ONCE_INIT;
+static _Thread_local HashBox *box_cache = NULL;
+static _Thread_local size_t box_cache_count = 0;
+
+static _Atomic unsigned next_stripe = 0;
+static _Thread_local unsigned local_stripe = UINT32_MAX;
+
+static HashCounterStripe *ch_counter(ConcurrentHashTable *ct) {
+    if(local_stripe == UINT32_MAX) {
+        local_stripe = atomic_fetch_add_explicit(&next_stripe, 1, memory_order_relaxed) % HT_COUNTER_STRIPES;
+    }
+
+    return &ct->counters[local_stripe];
+}
+
+static size_t ch_live_count(ConcurrentHashTable *ct) {
+    intptr_t count = 0;
+
+    for(size_t i = 0; i < HT_COUNTER_STRIPES; i++) {
+        count += atomic_load_explicit(&ct->counters[i].count, memory_order_relaxed);
+    }
+
+    return count > 0 ? (size_t)count : 0;
+}
+
+static HashConcurrentArray *ch_alloc_array(size_t size) {
+    HashConcurrentArray *array = calloc(1, sizeof(HashConcurrentArray) + size * sizeof(HashConcurrentSlot));
+
+    if(!array) {
+        fputs("Cannot allocate a memory for hash table slots.\n", stderr);
+        return NULL;
+    }
+
+    array->size = size;
+
+    return array;
+}
+
+static void ch_depot_push(HashBox *batch) {
+    pthread_mutex_lock(&depot_lock);
+    batch->free.next_batch = depot;
+    depot = batch;
+    pthread_mutex_unlock(&depot_lock);
+}
+
+// Returns an exiting thread's cache to the depot
+static void ch_release_cache(void *unused) {
+    (void)unused;
+
+    if(box_cache) {
+        ch_depot_push(box_cache);
+        box_cache = NULL;
+        box_cache_count = 0;
+    }
+}
+
+static void ch_create_cache_key(void) {
+    pthread_key_create(&box_cache_key, ch_release_cache);
+}
+
+static bool ch_refill_cache(void) {
+    pthread_once(&box_cache_once, ch_create_cache_key);
+    pthread_setspecific(box_cache_key, &box_cache);
+    pthread_mutex_lock(&depot_lock);
+
+    HashBox *batch = depot;
+
+    if(batch) {
+        depot = batch->free.next_batch;
+    }
+
+    pthread_mutex_unlock(&depot_lock);
+
+    if(batch) {
+        box_cache = batch;
+        box_cache_count = HT_BOX_BATCH;
+        return true;
+    }
+
+    HashBox *block = malloc((HT_BOX_BATCH + 1) * sizeof(HashBox));
+
+    if(!block) {
+        return false;
+    }
+
+    pthread_mutex_lock(&depot_lock);
+    block->free.next = box_blocks;
+    box_blocks = block;
+    pthread_mutex_unlock(&depot_lock);
+
+    for(size_t i = 1; i < HT_BOX_BATCH; i++) {
+        block[i].free.next = &block[i + 1];
+    }
+
+    block[HT_BOX_BATCH].free.next = NULL;
+    box_cache = &block[1];
+    box_cache_count = HT_BOX_BATCH;
+
+    return true;
+}
+
+static void **ch_new_box(void *value) {
+    if(!box_cache && !ch_refill_cache()) {
+        fputs("Cannot allocate a memory for hash table value.\n", stderr);
+        return NULL;
+    }
+
+    HashBox *box = box_cache;
+
+    box_cache = box->free.next;
+    box_cache_count -= box_cache_count > 0;
+    box->value = value;
+
+    return &box->value;
+}
+
+// Also the destroy callback of retired boxes, so it runs on the thread that frees them
+static void ch_free_box(void *ptr) {
+    HashBox *box = ptr;
+
+    box->free.next = box_cache;
+    box_cache = box;
+
+    if(++box_cache_count < 2 * HT_BOX_BATCH) {
+        return;
+    }
+
+    // Keep one batch and hand the rest back, so threads that only delete do not hoard boxes
+    HashBox *last = box_cache;
+
+    // The count is an estimate once batches of other sizes came from the depot, so walk carefully
+    for(size_t i = 1; i < HT_BOX_BATCH && last->free.next; i++) {
+        last = last->free.next;
+    }
+
+    HashBox *batch = last->free.next;
+
+    last->free.next = NULL;
+    box_cache_count = HT_BOX_BATCH;
+
+    if(batch) {
+        ch_depot_push(batch);
+    }
+}
+
+// Finds the slot of key, claiming an empty one if claim is set.
+// Returns SIZE_MAX if the key is absent (or, when claiming, if the array is full).
+static size_t ch_slot(HashConcurrentArray *array, const char *key, uint32_t hash_value, bool claim) {
+    size_t index = hash_value % array->size;
+
+    for(size_t probes = 0; probes < array->size; probes++) {
+        HashConcurrentSlot *slot = &array->slots[index];
+        const char *current = atomic_load_explicit(&slot->key, memory_order_acquire);
+
+        if(!current) {
+            if(!claim) {
+                return SIZE_MAX;
+            }
+
+            if(atomic_compare_exchange_strong(&slot->key, &current, key)) {
+                atomic_fetch_add_explicit(&array->claimed, 1, memory_order_relaxed);
+                return index;
+            }
+        }
+
+        if(current == key || strcmp(current, key) == 0) {
+            return index;
+        }
+
+        index = (index + 1) % array->size;
+    }
+
+    return SIZE_MAX;
+}
+
+// Attaches a next array to migrate into, or returns the one another thread attached
+static HashConcurrentArray *ch_start_resize(ConcurrentHashTable *ct, HashConcurrentArray *array) {
+    HashConcurrentArray *next = atomic_load(&array->next);
+
+    if(next) {
+        return next;
+    }
+
+    // Double only when live entries warrant it; otherwise just sweep out the tombstones
+    size_t live = ch_live_count(ct);
+    size_t new_size = array->size;
+
+    if((float)(live + 1) / (float)array->size > LOAD_FACTOR_THRESHOLD / 2) {
+        new_size = array->size > SIZE_MAX / 4 ? array->size : array->size * 2;
+    }
+
+    HashConcurrentArray *fresh = ch_alloc_array(new_size);
+
+    if(!fresh) {
+        return NULL;
+    }
+
+    if(!atomic_compare_exchange_strong(&array->next, &next, fresh)) {
+        free(fresh);
+        return next;
+    }
+
+    return fresh;
+}
+
+static uintptr_t ch_put(ConcurrentHashTable *ct, HashConcurrentArray *array, const char *key, uint32_t hash_value, uintptr_t value, HashConcurrentMode mode);
+
+// Promotes fully migrated arrays, oldest first
+static void ch_promote(ConcurrentHashTable *ct) {
+    for(;;) {
+        HashConcurrentArray *top = atomic_load(&ct->top);
+        HashConcurrentArray *next = atomic_load(&top->next);
+
+        if(!next || atomic_load(&top->copy_done) < top->size) {
+            return;
+        }
+
+        if(atomic_compare_exchange_strong(&ct->top, &top, next)) {
+            ht_epoch_retire(top, free);
+        }
+    }
+}
+
+// Counts slots marked CH_MOVED and promotes the array once all of them are
+static void ch_count_moved(ConcurrentHashTable *ct, HashConcurrentArray *array, size_t moved) {
+    if(moved && atomic_fetch_add(&array->copy_done, moved) + moved == array->size) {
+        ch_promote(ct);
+    }
+}
+
+// Migrates one slot of array into array->next and adds 1 to *moved if this call marked it CH_MOVED.
+// Returns false, leaving the slot primed, if the copy could not be allocated.
+static bool ch_copy_slot(ConcurrentHashTable *ct, HashConcurrentArray *array, size_t index, size_t *moved) {
+    HashConcurrentSlot *slot = &array->slots[index];
+    HashConcurrentArray *next = atomic_load(&array->next);
+    uintptr_t current = atomic_load(&slot->value);
+
+    for(;;) {
+        if(current == CH_MOVED) {
+            return true;
+        }
+
+        // Nothing to copy; freezing the slot keeps late writers out of it
+        if(current == CH_NEVER || current == CH_TOMB) {
+            if(atomic_compare_exchange_weak(&slot->value, &current, CH_MOVED)) {
+                (*moved)++;
+                return true;
+            }
+
+            continue;
+        }
+
+        if(!(current & CH_PRIME)) {
+            if(!atomic_compare_exchange_weak(&slot->value, &current, current | CH_PRIME)) {
+                continue;
+            }
+
+            current |= CH_PRIME;
+        }
+
+        break;
+    }
+
+    // Every helper copies into a box of its own, so ownership of each box stays unambiguous
+    void **old_box = CH_BOX(current);
+    void **box = ch_new_box(*old_box);
+
+    if(!box) {
+        return false;
+    }
+
+    const char *key = atomic_load_explicit(&slot->key, memory_order_relaxed);
+    uintptr_t replaced = ch_put(ct, next, key, ht_fnv1a(key), (uintptr_t)box, CH_COPY);
+
+    if(replaced != CH_NEVER) {
+        ch_free_box(box);
+    }
+
+    // The next array had no room and none could be attached; the entry stays here
+    if(replaced == CH_MOVED) {
+        return false;
+    }
+
+    if(atomic_compare_exchange_strong(&slot->value, &current, CH_MOVED)) {
+        ht_epoch_retire(old_box, ch_free_box);
+        (*moved)++;
+    }
+
+    return true;
+}
+
+static void ch_copy_range(ConcurrentHashTable *ct, HashConcurrentArray *array, size_t start, size_t end) {
+    size_t moved = 0;
+    bool failed = false;
+
+    for(size_t i = start; i < end; i++) {
+        failed |= !ch_copy_slot(ct, array, i, &moved);
+    }
+
+    if(failed) {
+        atomic_store(&array->copy_retry, true);
+    }
+
+    ch_count_moved(ct, array, moved);
+}
+
+// Migrates one chunk of the oldest array that still has unclaimed chunks, or sweeps
+// an array whose chunks are all claimed but left slots primed
+static void ch_help_migrate(ConcurrentHashTable *ct) {
+    for(HashConcurrentArray *array = atomic_load(&ct->top); array; array = atomic_load(&array->next)) {
+        if(!atomic_load(&array->next)) {
+            return;
+        }
+
+        size_t start = atomic_fetch_add(&array->copy_claim, HT_MIGRATE_CHUNK);
+
+        if(start < array->size) {
+            ch_copy_range(ct, array, start, array->size - start < HT_MIGRATE_CHUNK ? array->size : start + HT_MIGRATE_CHUNK);
+            return;
+        }
+
+        if(atomic_exchange(&array->copy_retry, false)) {
+            ch_copy_range(ct, array, 0, array->size);
+            return;
+        }
+    }
+}
+
+// Stores value (a box or CH_TOMB) for key and returns the value word it replaced, or
+// CH_MOVED if that needed memory that could not be allocated
+static uintptr_t ch_put(ConcurrentHashTable *ct, HashConcurrentArray *array, const char *key, uint32_t hash_value, uintptr_t value, HashConcurrentMode mode) {
+    for(;;) {
+        HashConcurrentArray *next = atomic_load(&array->next);
+        bool claim = value != CH_TOMB;
+
+        if(!next && claim && (float)(atomic_load_explicit(&array->claimed, memory_order_relaxed) + 1) / (float)array->size > LOAD_FACTOR_THRESHOLD) {
+            next = ch_start_resize(ct, array);
+        }
+
+        size_t index = ch_slot(array, key, hash_value, claim);
+
+        if(index == SIZE_MAX) {
+            if(!claim && !next) {
+                return CH_NEVER; // deleting a key that is not there
+            }
+
+            next = next ? next : ch_start_resize(ct, array);
+
+            if(!next) {
+                return CH_MOVED;
+            }
+
+            array = next;
+            continue;
+        }
+
+        HashConcurrentSlot *slot = &array->slots[index];
+        uintptr_t current = atomic_load(&slot->value);
+
+        for(;;) {
+            if(current == CH_MOVED) {
+                break;
+            }
+
+            // While a migration is running, writes go to the newest array after the old slot moves
+            if(next || (current & CH_PRIME)) {
+                size_t moved = 0;
+
+                if(!ch_copy_slot(ct, array, index, &moved)) {
+                    return CH_MOVED;
+                }
+
+                ch_count_moved(ct, array, moved);
+                current = atomic_load(&slot->value);
+                continue;
+            }
+
+            if(mode == CH_COPY && current != CH_NEVER) {
+                return current;
+            }
+
+            if(!claim && !CH_IS_BOX(current)) {
+                return current; // already deleted
+            }
+
+            if(atomic_compare_exchange_weak(&slot->value, &current, value)) {
+                return current;
+            }
+
+            next = atomic_load(&array->next);
+        }
+
+        array = atomic_load(&array->next);
+    }
+}
+
+bool ht_concurrent_set(ConcurrentHashTable *ct, const char *key, void *value) {
+    if(!ct) {
+        fputs("Cannot set a value for an unallocated hash table.\n", stderr);
+        return false;
+    }
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return false;
+    }
+    else if(*key == '\0') {
+        fputs("Key cannot be an empty string.\n", stderr);
+        return false;
+    }
+
+    void **box = ch_new_box(value);
+
+    if(!box) {
+        return false;
+    }
+
+    ht_epoch_enter();
+    ch_help_migrate(ct);
+
+    uintptr_t old = ch_put(ct, atomic_load(&ct->top), key, ht_fnv1a(key), (uintptr_t)box, CH_PUT);
+
+    if(old == CH_MOVED) {
+        ch_free_box(box);
+        ht_epoch_exit();
+        fprintf(stderr, "Hash table migration failed, cannot insert key '%s'.\n", key);
+
+        return false;
+    }
+
+    if(CH_IS_BOX(old)) {
+        ht_epoch_retire(CH_BOX(old), ch_free_box);
+    }
+    else {
+        atomic_fetch_add_explicit(&ch_counter(ct)->count, 1, memory_order_relaxed);
+    }
+
+    ht_epoch_exit();
+
+    return true;
+}
+
+const void *ht_concurrent_get(ConcurrentHashTable *ct, const char *key) {
+    void *value = NULL;
+
+    ht_concurrent_try_get(ct, key, &value);
+
+    return value;
+}
+
+bool ht_concurrent_try_get(ConcurrentHashTable *ct, const char *key, void **out) {
+    if(!ct || !key || *key == '\0') {
+        return false;
+    }
+
+    uint32_t hash_value = ht_fnv1a(key);
+    bool found = false;
+
+    ht_epoch_enter();
+
+    HashConcurrentArray *array = atomic_load_explicit(&ct->top, memory_order_acquire);
+
+    while(array) {
+        size_t index = ch_slot(array, key, hash_value, false);
+        HashConcurrentArray *next = atomic_load_explicit(&array->next, memory_order_acquire);
+
+        if(index == SIZE_MAX) {
+            array = next;
+            continue;
+        }
+
+        uintptr_t current = atomic_load_explicit(&array->slots[index].value, memory_order_acquire);
+
+        if(current == CH_MOVED) {
+            array = next;
+            continue;
+        }
+
+        if(CH_IS_BOX(current)) {
+            found = true;
+
+            if(out) {
+                *out = *CH_BOX(current);
+            }
+        }
+
+        break;
+    }
+
+    ht_epoch_exit();
+
+    return found;
+}
+
+void ht_concurrent_delete(ConcurrentHashTable *ct, const char *key) {
+    if(!ct || !key || *key == '\0') {
+        return;
+    }
+
+    ht_epoch_enter();
+    ch_help_migrate(ct);
+
+    uintptr_t old = ch_put(ct, atomic_load(&ct->top), key, ht_fnv1a(key), CH_TOMB, CH_PUT);
+
+    if(old == CH_MOVED) {
+        fprintf(stderr, "Hash table migration failed, cannot delete key '%s'.\n", key);
+    }
+    else if(CH_IS_BOX(old)) {
+        ht_epoch_retire(CH_BOX(old), ch_free_box);
+        atomic_fetch_sub_explicit(&ch_counter(ct)->count, 1, memory_order_relaxed);
+    }
+
+    ht_epoch_exit();
+}
+
+bool ht_concurrent_has(ConcurrentHashTable *ct, const char *key) {
+    return ht_concurrent_try_get(ct, key, NULL);
+}
+
+void ht_concurrent_free(ConcurrentHashTable **ct_ptr) {
+    if(!ct_ptr || !*ct_ptr) {
+        return;
+    }
+
+    ConcurrentHashTable *ct = *ct_ptr;
+    HashConcurrentArray *array = atomic_load(&ct->top);
+
+    while(array) {
+        HashConcurrentArray *next = atomic_load(&array->next);
+
+        for(size_t i = 0; i < array->size; i++) {
+            uintptr_t value = atomic_load_explicit(&array->slots[i].value, memory_order_relaxed);
+
+            if(CH_IS_BOX(value)) {
+                ch_free_box(CH_BOX(value));
+            }
+        }
+
+        free(array);
+        array = next;
+    }
+
+    free(ct);
+    *ct_ptr = NULL;
+}
+
+size_t ht_concurrent_count(ConcurrentHashTable *ct) {
+    if(!ct) {
+        fputs("Hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return ch_live_count(ct);
+}
+
+ConcurrentHashTable *ht_concurrent_init(size_t init_size) {
+    ConcurrentHashTable *ct = aligned_alloc(64, sizeof(ConcurrentHashTable));
+
+    if(!ct) {
+        fputs("Cannot allocate a memory for hash table struct.\n", stderr);
+        return NULL;
+    }
+
+    HashConcurrentArray *array = ch_alloc_array(init_size == 0 ? 1 : init_size);
+
+    if(!array) {
+        free(ct);
+        return NULL;
+    }
+
+    atomic_init(&ct->top, array);
+
+    for(size_t i = 0; i < HT_COUNTER_STRIPES; i++) {
+        atomic_init(&ct->counters[i].count, 0);
+    }
+
+    return ct;
+}
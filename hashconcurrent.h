@@ -0,0 +1,45 @@
+#ifndef HASH_CONCURRENT_H
+#define HASH_CONCURRENT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HT_COUNTER_STRIPES 16
+
+typedef struct {
+    _Atomic(const char *) key;  // claimed once, never released within an array
+    _Atomic uintptr_t value;    // state word, see hashconcurrent.c
+} HashConcurrentSlot;
+
+typedef struct HashConcurrentArray {
+    size_t size;
+    _Atomic(struct HashConcurrentArray *) next; // array being migrated into, if any
+    _Atomic size_t claimed;                     // slots whose key has been claimed
+    _Atomic size_t copy_claim;                  // next chunk to migrate
+    _Atomic size_t copy_done;                   // slots marked moved
+    _Atomic bool copy_retry;                    // a chunk left slots primed after a failed copy
+    HashConcurrentSlot slots[];
+} HashConcurrentArray;
+
+// Element counter striped over cache lines so that writers on different cores do not contend
+typedef struct {
+    _Alignas(64) _Atomic intptr_t count;
+} HashCounterStripe;
+
+typedef struct ConcurrentHashTable {
+    _Atomic(HashConcurrentArray *) top;
+    HashCounterStripe counters[HT_COUNTER_STRIPES];
+} ConcurrentHashTable;
+
+bool ht_concurrent_set(ConcurrentHashTable *ct, const char *key, void *value);
+const void *ht_concurrent_get(ConcurrentHashTable *ct, const char *key);
+bool ht_concurrent_try_get(ConcurrentHashTable *ct, const char *key, void **out);
+void ht_concurrent_delete(ConcurrentHashTable *ct, const char *key);
+bool ht_concurrent_has(ConcurrentHashTable *ct, const char *key);
+void ht_concurrent_free(ConcurrentHashTable **ct_ptr);
+size_t ht_concurrent_count(ConcurrentHashTable *ct);
+ConcurrentHashTable *ht_concurrent_init(size_t init_size);
+
+#endif
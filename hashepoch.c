@@ -0,0 +1,274 @@
+/*
+    Epoch-Based Memory Reclamation
+    
+    Description:
+    Lets writers free memory that lock-free readers may still be looking at. There is
+    one global epoch counter and one record per thread that has ever read. A reader
+    entering a read-side section copies the global epoch into its own record; leaving
+    the section clears it. Memory retired during epoch e is freed once the global
+    epoch has reached e + 2. The epoch only advances when every reader inside a
+    section has observed the current epoch, so by then no reader can still hold a
+    pointer to the retired memory.
+
+    Readers never write memory shared with other threads: each thread's record sits on
+    its own cache line and is found through a thread-local pointer. Records are
+    registered on first use and recycled when their thread exits.
+
+    Retiring takes no lock either. Each record keeps three bags of retired memory, one
+    per epoch modulo 3, which only the thread holding the record touches. A bag about
+    to be reused for epoch e held memory from epoch e - 3 or earlier, which is due, so
+    it is emptied first. Every HT_EPOCH_BATCH retirements the thread tries to advance
+    the epoch and frees its own bags that are due; ht_epoch_reclaim does so right away,
+    for writers that retire rarely but retire large objects. Bags keep their arrays, so
+    a thread that retires at a steady rate stops allocating. Memory left in the record
+    of a thread that exited is freed by the next thread to take the record, or by any
+    thread calling ht_epoch_reclaim or ht_epoch_synchronize.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashtable_internal.h"
+
+#define HT_EPOCH_BATCH 64
+#define HT_EPOCH_BAGS 3
+
+typedef struct {
+    void *ptr;
+    void (*destroy)(void *ptr);
+} HashRetired;
+
+// Memory one thread retired during one epoch
+typedef struct {
+    HashRetired *items;
+    size_t count;
+    size_t capacity;
+    uint64_t epoch;
+} HashRetireBag;
+
+typedef struct HashEpochRecord {
+    _Alignas(64) _Atomic uint64_t epoch; // 0 outside a read-side section
+    _Atomic bool in_use;
+    unsigned nesting;
+    struct HashEpochRecord *next;
+    _Alignas(64) HashRetireBag bags[HT_EPOCH_BAGS]; // only touched by the thread holding the record
+    size_t retired_since_reclaim;
+} HashEpochRecord;
+
+static _Atomic uint64_t global_epoch = 1;
+static _Atomic(HashEpochRecord *) records = NULL;
+static pthread_key_t record_key;
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local HashEpochRecord *local_record = NULL;
+
+static void release_record(void *ptr) {
+    HashEpochRecord *record = ptr;
+
+    atomic_store_explicit(&record->epoch, 0, memory_order_release);
+    atomic_store_explicit(&record->in_use, false, memory_order_release);
+}
+
+static void create_record_key(void) {
+    pthread_key_create(&record_key, release_record);
+}
+
+static HashEpochRecord *acquire_record(void) {
+    pthread_once(&record_key_once, create_record_key);
+
+    HashEpochRecord *record;
+
+    // Recycle the record of a thread that has exited
+    for(record = atomic_load(&records); record; record = record->next) {
+        bool expected = false;
+
+        if(!atomic_load_explicit(&record->in_use, memory_order_relaxed) &&
+           atomic_compare_exchange_strong(&record->in_use, &expected, true)) {
+            break;
+        }
+    }
+
+    if(!record) {
+        record = aligned_alloc(64, sizeof(HashEpochRecord));
+
+        // Without a record this thread cannot be tracked, which is unrecoverable
+        if(!record) {
+            abort();
+        }
+
+        memset(record->bags, 0, sizeof(record->bags));
+        record->retired_since_reclaim = 0;
+        atomic_init(&record->epoch, 0);
+        atomic_init(&record->in_use, true);
+        record->next = atomic_load(&records);
+
+        while(!atomic_compare_exchange_weak(&records, &record->next, record));
+    }
+
+    record->nesting = 0;
+    local_record = record;
+    pthread_setspecific(record_key, record);
+
+    return record;
+}
+
+void ht_epoch_enter(void) {
+    HashEpochRecord *record = local_record ? local_record : acquire_record();
+
+    if(record->nesting++ == 0) {
+        atomic_store_explicit(&record->epoch, atomic_load_explicit(&global_epoch, memory_order_relaxed), memory_order_relaxed);
+
+        // The epoch must be visible to writers before any shared pointer is read
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+}
+
+void ht_epoch_exit(void) {
+    HashEpochRecord *record = local_record;
+
+    if(--record->nesting == 0) {
+        atomic_store_explicit(&record->epoch, 0, memory_order_release);
+    }
+}
+
+// Advances the global epoch if every active reader has observed it; returns the epoch
+static uint64_t try_advance(void) {
+    uint64_t epoch = atomic_load(&global_epoch);
+
+    // Pairs with the fence in ht_epoch_enter: unlinks made before now are visible to later readers
+    atomic_thread_fence(memory_order_seq_cst);
+
+    for(HashEpochRecord *record = atomic_load(&records); record; record = record->next) {
+        uint64_t observed = atomic_load_explicit(&record->epoch, memory_order_acquire);
+
+        if(observed != 0 && observed != epoch) {
+            return epoch;
+        }
+    }
+
+    atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+
+    return atomic_load(&global_epoch);
+}
+
+// Destroys everything in the bag. The array is detached first, since a destroy
+// callback may retire more memory into the same bag.
+static void empty_bag(HashRetireBag *bag) {
+    HashRetired *items = bag->items;
+    size_t count = bag->count;
+    size_t capacity = bag->capacity;
+
+    bag->items = NULL;
+    bag->count = 0;
+    bag->capacity = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        items[i].destroy(items[i].ptr);
+    }
+
+    if(bag->items) {
+        free(items);
+    }
+    else {
+        bag->items = items;
+        bag->capacity = capacity;
+    }
+}
+
+static void free_due(HashEpochRecord *record, uint64_t epoch) {
+    for(size_t i = 0; i < HT_EPOCH_BAGS; i++) {
+        if(record->bags[i].count && record->bags[i].epoch + 2 <= epoch) {
+            empty_bag(&record->bags[i]);
+        }
+    }
+}
+
+// Frees what is due in the caller's record and in the records of threads that exited
+static void reclaim_all(uint64_t epoch) {
+    HashEpochRecord *own = local_record;
+
+    if(own) {
+        free_due(own, epoch);
+    }
+
+    for(HashEpochRecord *record = atomic_load(&records); record; record = record->next) {
+        bool expected = false;
+
+        if(record != own && !atomic_load_explicit(&record->in_use, memory_order_relaxed) &&
+           atomic_compare_exchange_strong(&record->in_use, &expected, true)) {
+            free_due(record, epoch);
+            atomic_store_explicit(&record->in_use, false, memory_order_release);
+        }
+    }
+}
+
+static bool grow_bag(HashRetireBag *bag) {
+    size_t capacity = bag->capacity ? bag->capacity * 2 : HT_EPOCH_BATCH;
+    HashRetired *items = realloc(bag->items, capacity * sizeof(HashRetired));
+
+    if(!items) {
+        return false;
+    }
+
+    bag->items = items;
+    bag->capacity = capacity;
+
+    return true;
+}
+
+void ht_epoch_retire(void *ptr, void (*destroy)(void *ptr)) {
+    HashEpochRecord *record = local_record ? local_record : acquire_record();
+    uint64_t epoch = atomic_load(&global_epoch);
+    HashRetireBag *bag = &record->bags[epoch % HT_EPOCH_BAGS];
+
+    // The bag last held epoch - 3 or earlier, which no reader can reach any more
+    if(bag->epoch != epoch) {
+        empty_bag(bag);
+        bag->epoch = epoch;
+    }
+
+    if(bag->count == bag->capacity && !grow_bag(bag)) {
+        // Freeing what is due may make room for the bag to grow
+        free_due(record, try_advance());
+
+        if(!grow_bag(bag)) {
+            // A grace period cannot be waited out inside a read-side section, where most memory is retired
+            if(record->nesting == 0) {
+                ht_epoch_synchronize();
+                destroy(ptr);
+            }
+            else {
+                fputs("Cannot allocate a memory to retire an object, it is leaked.\n", stderr);
+            }
+
+            return;
+        }
+    }
+
+    bag->items[bag->count++] = (HashRetired){ptr, destroy};
+
+    if(++record->retired_since_reclaim >= HT_EPOCH_BATCH) {
+        record->retired_since_reclaim = 0;
+        free_due(record, try_advance());
+    }
+}
+
+void ht_epoch_reclaim(void) {
+    // Two advances cover memory retired just now, unless a reader is inside a section
+    try_advance();
+    reclaim_all(try_advance());
+}
+
+void ht_epoch_synchronize(void) {
+    uint64_t target = atomic_load(&global_epoch) + 2;
+    uint64_t epoch;
+
+    while((epoch = try_advance()) < target) {
+        sched_yield();
+    }
+
+    reclaim_all(epoch);
+}
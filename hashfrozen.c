@@ -0,0 +1,371 @@
+/*
+    Frozen Tables (Minimal Perfect Hashing)
+    
+    Description:
+    Turns a populated hash table into an immutable table addressed by a minimal
+    perfect hash, for key sets that are built once and then only read. Every key maps
+    to its own slot and there are exactly as many slots as keys, so a lookup is one
+    hash, one slot access and one key comparison, with no probing and no empty slots.
+
+    The construction follows PTHash. Keys are hashed with a seeded 64-bit hash and
+    split into buckets of a few keys each. Buckets are processed from the largest
+    down, and for each one a 16-bit pilot value is searched for that moves all of its
+    keys to positions no earlier key has taken. Searching is cheap while the table is
+    empty and gets harder as it fills, so the construction targets slightly more
+    positions than keys (99% load). The few keys that land past the last slot are sent
+    to the free slots below it through a small remap array. If some bucket finds no
+    pilot, the construction starts over with another seed.
+
+    Space overhead is the pilot array, one 16-bit value per bucket with about
+    log2(n) / 6 keys per bucket, which comes to a few bits per key, plus 4 bytes for
+    each of the roughly 1% remapped positions.
+
+    Keys and values are not copied: the frozen table points to the same keys and
+    values as the hash table it was built from, which may be freed afterwards. Entries
+    that have expired are left out.
+
+    Functions:
+    - Construction (`ht_freeze`).
+    - Retrieval and existence check (`ht_frozen_get`, `ht_frozen_try_get`, `ht_frozen_has`).
+    - Number of entries (`ht_frozen_count`).
+    - Memory management (`ht_frozen_free`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashfrozen.h"
+#include "hashtable_internal.h"
+
+#define HT_FROZEN_KEYS_PER_BUCKET_FACTOR 6.0 // buckets hold log2(n) / this many keys on average
+#define HT_FROZEN_LOAD 0.99
+#define HT_FROZEN_SEEDS 32
+
+typedef struct {
+    size_t count;
+    uint64_t *hashes;
+    size_t *bucket_start; // keys of bucket b are order[bucket_start[b] .. bucket_start[b + 1])
+    size_t *order;
+    size_t *buckets;      // bucket indices, largest bucket first
+    size_t *positions;    // position of every key
+    uint64_t *taken;      // bitmap over the table's positions
+} FrozenBuild;
+
+static bool is_taken(const uint64_t *taken, size_t position) {
+    return taken[position / 64] & (1ULL << (position % 64));
+}
+
+static void set_taken(uint64_t *taken, size_t position, bool value) {
+    if(value) {
+        taken[position / 64] |= 1ULL << (position % 64);
+    }
+    else {
+        taken[position / 64] &= ~(1ULL << (position % 64));
+    }
+}
+
+// Groups the keys by bucket and orders the buckets by size, largest first
+static bool sort_buckets(FrozenBuild *build, HashFrozen *frozen) {
+    size_t *sizes = build->bucket_start;
+    size_t max_size = 0;
+
+    memset(sizes, 0, (frozen->bucket_count + 1) * sizeof(size_t));
+
+    for(size_t i = 0; i < build->count; i++) {
+        size_t bucket = ht_frozen_bucket(build->hashes[i], frozen->bucket_count, frozen->dense_buckets);
+
+        sizes[bucket + 1]++;
+        max_size = sizes[bucket + 1] > max_size ? sizes[bucket + 1] : max_size;
+    }
+
+    // Counting sort of the buckets by size, descending
+    size_t *by_size = calloc(max_size + 2, sizeof(size_t));
+
+    if(!by_size) {
+        fputs("Cannot allocate a memory for frozen hash table construction.\n", stderr);
+        return false;
+    }
+
+    for(size_t bucket = 0; bucket < frozen->bucket_count; bucket++) {
+        by_size[max_size - sizes[bucket + 1] + 1]++;
+    }
+
+    for(size_t size = 1; size <= max_size + 1; size++) {
+        by_size[size] += by_size[size - 1];
+    }
+
+    for(size_t bucket = 0; bucket < frozen->bucket_count; bucket++) {
+        build->buckets[by_size[max_size - sizes[bucket + 1]]++] = bucket;
+    }
+
+    free(by_size);
+
+    for(size_t bucket = 0; bucket < frozen->bucket_count; bucket++) {
+        sizes[bucket + 1] += sizes[bucket];
+    }
+
+    // Scatter the keys; bucket_start[b] runs ahead by one bucket and ends up in place
+    for(size_t i = 0; i < build->count; i++) {
+        size_t bucket = ht_frozen_bucket(build->hashes[i], frozen->bucket_count, frozen->dense_buckets);
+
+        build->order[sizes[bucket]++] = i;
+    }
+
+    memmove(sizes + 1, sizes, frozen->bucket_count * sizeof(size_t));
+    sizes[0] = 0;
+
+    return true;
+}
+
+// Finds a pilot for every bucket; false if some bucket has none under this seed
+static bool place_buckets(FrozenBuild *build, HashFrozen *frozen, uint16_t *pilots) {
+    memset(build->taken, 0, (frozen->table_size + 63) / 64 * sizeof(uint64_t));
+
+    for(size_t b = 0; b < frozen->bucket_count; b++) {
+        size_t bucket = build->buckets[b];
+        size_t first = build->bucket_start[bucket];
+        size_t last = build->bucket_start[bucket + 1];
+        bool placed = false;
+
+        if(first == last) {
+            pilots[bucket] = 0;
+            continue;
+        }
+
+        for(uint32_t pilot = 0; pilot <= UINT16_MAX && !placed; pilot++) {
+            size_t j = first;
+
+            for(; j < last; j++) {
+                size_t key = build->order[j];
+                size_t position = ht_frozen_position(build->hashes[key], (uint16_t)pilot, frozen->table_size);
+
+                // Also catches two keys of this bucket landing on the same position
+                if(is_taken(build->taken, position)) {
+                    break;
+                }
+
+                build->positions[key] = position;
+                set_taken(build->taken, position, true);
+            }
+
+            placed = j == last;
+
+            // Undo a partial placement before trying the next pilot
+            while(!placed && j-- > first) {
+                set_taken(build->taken, build->positions[build->order[j]], false);
+            }
+
+            pilots[bucket] = (uint16_t)pilot;
+        }
+
+        if(!placed) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool build_frozen(HashFrozen *frozen, HashFrozenEntry *collected, uint16_t *pilots, uint32_t *remap, HashFrozenEntry *entries) {
+    FrozenBuild build = {frozen->count};
+
+    build.hashes = malloc(frozen->count * sizeof(uint64_t));
+    build.bucket_start = malloc((frozen->bucket_count + 1) * sizeof(size_t));
+    build.order = malloc(frozen->count * sizeof(size_t));
+    build.buckets = malloc(frozen->bucket_count * sizeof(size_t));
+    build.positions = malloc(frozen->count * sizeof(size_t));
+    build.taken = malloc((frozen->table_size + 63) / 64 * sizeof(uint64_t));
+
+    bool ok = build.hashes && build.bucket_start && build.order && build.buckets && build.positions && build.taken;
+
+    if(!ok) {
+        fputs("Cannot allocate a memory for frozen hash table construction.\n", stderr);
+    }
+
+    for(unsigned attempt = 0; ok && attempt < HT_FROZEN_SEEDS; attempt++) {
+        frozen->seed = ht_mix64(attempt + 1);
+
+        for(size_t i = 0; i < frozen->count; i++) {
+            build.hashes[i] = ht_frozen_hash(collected[i].key, frozen->seed);
+        }
+
+        if(!sort_buckets(&build, frozen)) {
+            ok = false;
+        }
+        else if(place_buckets(&build, frozen, pilots)) {
+            break;
+        }
+        else if(attempt + 1 == HT_FROZEN_SEEDS) {
+            fputs("Cannot freeze hash table: no perfect hash found.\n", stderr);
+            ok = false;
+        }
+    }
+
+    if(ok) {
+        // Send the positions past the last slot to the slots nobody took
+        size_t free_slot = 0;
+
+        for(size_t position = frozen->count; position < frozen->table_size; position++) {
+            while(free_slot < frozen->count && is_taken(build.taken, free_slot)) {
+                free_slot++;
+            }
+
+            if(is_taken(build.taken, position)) {
+                remap[position - frozen->count] = (uint32_t)free_slot++;
+            }
+        }
+
+        for(size_t i = 0; i < frozen->count; i++) {
+            size_t position = build.positions[i];
+
+            entries[position < frozen->count ? position : remap[position - frozen->count]] = collected[i];
+        }
+    }
+
+    free(build.hashes);
+    free(build.bucket_start);
+    free(build.order);
+    free(build.buckets);
+    free(build.positions);
+    free(build.taken);
+
+    return ok;
+}
+
+HashFrozen *ht_freeze(HashTable *ht) {
+    if(!ht || !ht->table) {
+        fputs("Cannot freeze an unallocated hash table.\n", stderr);
+        return NULL;
+    }
+    else if(ht->element_count > UINT32_MAX) {
+        fputs("Cannot freeze a hash table of more than 2^32 entries.\n", stderr);
+        return NULL;
+    }
+
+    HashFrozen *frozen = calloc(1, sizeof(HashFrozen));
+    HashFrozenEntry *collected = malloc((ht->element_count ? ht->element_count : 1) * sizeof(HashFrozenEntry));
+
+    if(!frozen || !collected) {
+        free(frozen);
+        free(collected);
+        fputs("Cannot allocate a memory for frozen hash table.\n", stderr);
+
+        return NULL;
+    }
+
+    for(size_t i = 0; i < ht->size; i++) {
+        HashSlot *slot = ht->table[i];
+
+        if(slot && slot != TOMBSTONE && !(slot->timer && slot->timer->expires_at <= ht->wheel->clock)) {
+            collected[frozen->count].key = slot->key;
+            collected[frozen->count].value = slot->value;
+            frozen->count++;
+        }
+    }
+
+    if(frozen->count == 0) {
+        free(collected);
+        return frozen;
+    }
+
+    size_t log_count = 1;
+
+    while(log_count < 63 && ((size_t)1 << (log_count + 1)) <= frozen->count) {
+        log_count++;
+    }
+
+    frozen->table_size = (size_t)(frozen->count / HT_FROZEN_LOAD) + 1;
+    frozen->bucket_count = (size_t)(HT_FROZEN_KEYS_PER_BUCKET_FACTOR * frozen->count / log_count) + 1;
+    frozen->dense_buckets = (size_t)(0.3 * frozen->bucket_count) + 1;
+
+    uint16_t *pilots = malloc(frozen->bucket_count * sizeof(uint16_t));
+    uint32_t *remap = calloc(frozen->table_size - frozen->count, sizeof(uint32_t));
+    HashFrozenEntry *entries = malloc(frozen->count * sizeof(HashFrozenEntry));
+
+    if(!pilots || !remap || !entries || !build_frozen(frozen, collected, pilots, remap, entries)) {
+        if(!pilots || !remap || !entries) {
+            fputs("Cannot allocate a memory for frozen hash table.\n", stderr);
+        }
+
+        free(pilots);
+        free(remap);
+        free(entries);
+        free(collected);
+        free(frozen);
+
+        return NULL;
+    }
+
+    free(collected);
+    frozen->pilots = pilots;
+    frozen->remap = remap;
+    frozen->entries = entries;
+
+    return frozen;
+}
+
+static const HashFrozenEntry *frozen_find(const HashFrozen *frozen, const char *key) {
+    if(!frozen || frozen->count == 0 || !key) {
+        return NULL;
+    }
+
+    uint64_t hash_value = ht_frozen_hash(key, frozen->seed);
+    size_t bucket = ht_frozen_bucket(hash_value, frozen->bucket_count, frozen->dense_buckets);
+    size_t position = ht_frozen_position(hash_value, frozen->pilots[bucket], frozen->table_size);
+
+    if(position >= frozen->count) {
+        position = frozen->remap[position - frozen->count];
+    }
+
+    const HashFrozenEntry *entry = &frozen->entries[position];
+
+    return strcmp(entry->key, key) == 0 ? entry : NULL;
+}
+
+const void *ht_frozen_get(const HashFrozen *frozen, const char *key) {
+    const HashFrozenEntry *entry = frozen_find(frozen, key);
+
+    return entry ? entry->value : NULL;
+}
+
+bool ht_frozen_try_get(const HashFrozen *frozen, const char *key, void **out) {
+    const HashFrozenEntry *entry = frozen_find(frozen, key);
+
+    if(!entry) {
+        return false;
+    }
+
+    if(out) {
+        *out = entry->value;
+    }
+
+    return true;
+}
+
+bool ht_frozen_has(const HashFrozen *frozen, const char *key) {
+    return frozen_find(frozen, key) != NULL;
+}
+
+void ht_frozen_free(HashFrozen **frozen_ptr) {
+    if(!frozen_ptr || !*frozen_ptr) {
+        return;
+    }
+
+    HashFrozen *frozen = *frozen_ptr;
+
+    free((void *)frozen->pilots);
+    free((void *)frozen->remap);
+    free((void *)frozen->entries);
+    free(frozen);
+    *frozen_ptr = NULL;
+}
+
+size_t ht_frozen_count(const HashFrozen *frozen) {
+    if(!frozen) {
+        fputs("Frozen hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return frozen->count;
+}
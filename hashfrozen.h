@@ -0,0 +1,34 @@
+#ifndef HASH_FROZEN_H
+#define HASH_FROZEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hashtable.h"
+
+typedef struct {
+    const char *key;
+    void *value;
+} HashFrozenEntry;
+
+// Immutable table addressed by a minimal perfect hash: entries[] has no empty slots
+typedef struct HashFrozen {
+    size_t count;          // entries, which is also the number of slots
+    size_t table_size;     // positions the pilots map keys to; those past count are remapped
+    size_t bucket_count;
+    size_t dense_buckets;  // the first buckets, which receive most of the keys
+    uint64_t seed;
+    const uint16_t *pilots;  // one per bucket
+    const uint32_t *remap;   // table_size - count entries
+    const HashFrozenEntry *entries;
+} HashFrozen;
+
+HashFrozen *ht_freeze(HashTable *ht);
+const void *ht_frozen_get(const HashFrozen *frozen, const char *key);
+bool ht_frozen_try_get(const HashFrozen *frozen, const char *key, void **out);
+bool ht_frozen_has(const HashFrozen *frozen, const char *key);
+void ht_frozen_free(HashFrozen **frozen_ptr);
+size_t ht_frozen_count(const HashFrozen *frozen);
+
+#endif
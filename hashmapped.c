@@ -0,0 +1,186 @@
+/*
+    Memory-Mapped Read-Only Tables
+    
+    Description:
+    Queries a table file written by `ht_save` directly from a read-only memory mapping.
+    The file format uses offsets instead of pointers, so the mapping works at whatever
+    address it lands: opening a table only maps the file and checks its header, and
+    lookups probe the mapped slot array in place. Processes that map the same file
+    share its pages through the page cache, so reference data used by many workers is
+    held in memory once, and a restart costs nothing but the mapping.
+
+    Each entry record holds the full hash of its key, so a probe only touches a key in
+    the blob when the hashes match. Every offset read from the file is checked against
+    the mapping before it is followed, so a damaged file can give wrong answers but
+    never makes a lookup read outside the mapping. `ht_map_verify` checks the whole
+    file's checksum, at the cost of reading all of it.
+
+    Values are returned as pointers into the mapping and must be treated as read-only.
+    Expiry times stored in the file are not applied: a mapped table has no clock.
+
+    Functions:
+    - Opening and closing (`ht_map_open`, `ht_map_close`).
+    - Retrieval and existence check (`ht_map_get`, `ht_map_try_get`, `ht_map_has`);
+      `ht_map_try_get` also reports the value's length in bytes.
+    - Checksum verification (`ht_map_verify`).
+    - Utility (`ht_map_size`, `ht_map_count`).
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hashmapped.h"
+#include "hashtable_internal.h"
+
+static const HashFileEntry *find_entry(MappedHashTable *mht, const char *key) {
+    if(!mht || !key || *key == '\0' || mht->count == 0) {
+        return NULL;
+    }
+
+    uint32_t hash_value = ht_fnv1a(key);
+    size_t key_length = strlen(key);
+    uint64_t index = hash_value % mht->size;
+
+    for(uint64_t step = 0; step < mht->size; step++) {
+        uint64_t ref = mht->slots[index];
+
+        if(ref == 0) {
+            return NULL;
+        }
+        else if(ref != HT_FILE_TOMBSTONE && ref <= mht->count) {
+            const HashFileEntry *entry = &mht->entries[ref - 1];
+
+            if(entry->hash == hash_value
+                && entry->key_length == key_length
+                && ht_file_in_bounds(entry->key_offset, key_length, mht->blob_size)
+                && memcmp(mht->blob + entry->key_offset, key, key_length) == 0) {
+                return entry;
+            }
+        }
+
+        index = index + 1 == mht->size ? 0 : index + 1;
+    }
+
+    return NULL;
+}
+
+const void *ht_map_get(MappedHashTable *mht, const char *key) {
+    const void *value = NULL;
+
+    ht_map_try_get(mht, key, &value, NULL);
+
+    return value;
+}
+
+bool ht_map_try_get(MappedHashTable *mht, const char *key, const void **out, size_t *length) {
+    const HashFileEntry *entry = find_entry(mht, key);
+
+    if(!entry) {
+        return false;
+    }
+
+    bool has_value = entry->value_offset != HT_FILE_NULL_VALUE
+        && ht_file_in_bounds(entry->value_offset, entry->value_length, mht->blob_size);
+
+    if(out) {
+        *out = has_value ? mht->blob + entry->value_offset : NULL;
+    }
+
+    if(length) {
+        *length = has_value ? entry->value_length : 0;
+    }
+
+    return true;
+}
+
+bool ht_map_has(MappedHashTable *mht, const char *key) {
+    return find_entry(mht, key) != NULL;
+}
+
+bool ht_map_verify(MappedHashTable *mht) {
+    return mht && ht_file_validate(mht->data, mht->length, true) != NULL;
+}
+
+void ht_map_close(MappedHashTable **mht_ptr) {
+    if(!mht_ptr || !*mht_ptr) {
+        return;
+    }
+
+    munmap((void *)(*mht_ptr)->data, (*mht_ptr)->length);
+    free(*mht_ptr);
+    *mht_ptr = NULL;
+}
+
+size_t ht_map_size(MappedHashTable *mht) {
+    if(!mht) {
+        fputs("Mapped hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return mht->size;
+}
+
+size_t ht_map_count(MappedHashTable *mht) {
+    if(!mht) {
+        fputs("Mapped hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return mht->count;
+}
+
+MappedHashTable *ht_map_open(const char *path) {
+    if(!path) {
+        fputs("Table file path cannot be NULL.\n", stderr);
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Cannot open hash table file '%s': %s.\n", path, strerror(errno));
+
+        if(fd >= 0) {
+            close(fd);
+        }
+
+        return NULL;
+    }
+
+    size_t length = st.st_size;
+    void *data = length > 0 ? mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+    close(fd);
+
+    if(data == MAP_FAILED) {
+        fprintf(stderr, "Cannot map hash table file '%s'.\n", path);
+        return NULL;
+    }
+
+    // Lookups bound every read by the blob, which validation keeps inside the mapping
+    const HashFileHeader *header = ht_file_validate(data, length, false);
+    MappedHashTable *mht = header ? malloc(sizeof(MappedHashTable)) : NULL;
+
+    if(!mht) {
+        munmap(data, length);
+        return NULL;
+    }
+
+    mht->data = data;
+    mht->length = length;
+    mht->size = header->size;
+    mht->count = header->count;
+    mht->slots = (const uint64_t *)((const char *)data + header->slots_offset);
+    mht->entries = (const HashFileEntry *)((const char *)data + header->entries_offset);
+    mht->blob = (const char *)data + header->blob_offset;
+    mht->blob_size = header->blob_size;
+
+    return mht;
+}
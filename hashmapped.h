@@ -0,0 +1,31 @@
+#ifndef HASH_MAPPED_H
+#define HASH_MAPPED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct HashFileEntry;
+
+// A table file saved by ht_save, mapped read-only and queried in place
+typedef struct MappedHashTable {
+    const unsigned char *data;
+    size_t length;
+    uint64_t size;  // slots
+    uint64_t count; // entries
+    const uint64_t *slots;
+    const struct HashFileEntry *entries;
+    const char *blob;
+    uint64_t blob_size;
+} MappedHashTable;
+
+const void *ht_map_get(MappedHashTable *mht, const char *key);
+bool ht_map_try_get(MappedHashTable *mht, const char *key, const void **out, size_t *length);
+bool ht_map_has(MappedHashTable *mht, const char *key);
+bool ht_map_verify(MappedHashTable *mht);
+void ht_map_close(MappedHashTable **mht_ptr);
+size_t ht_map_size(MappedHashTable *mht);
+size_t ht_map_count(MappedHashTable *mht);
+MappedHashTable *ht_map_open(const char *path);
+
+#endif
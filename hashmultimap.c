@@ -0,0 +1,401 @@
+/*
+    Open Addressing Hash Multimap
+    
+    Description:
+    Maps a string key to any number of values. Instead of hanging a separately
+    allocated array off every key, the values of each key are kept contiguous in a
+    single shared value arena. Each slot records where its run starts, how many values
+    it holds and how many it can hold.
+
+    - Appending to a run with spare capacity is a single store. A full run at the end
+      of the arena grows in place; any other full run moves to the end of the arena
+      with doubled capacity, so appends are amortized O(1).
+    - Reading is one probe followed by a sequential scan of the run.
+    - Space left behind by moved or deleted runs is reclaimed by compacting the arena
+      once it accounts for more than half of it.
+
+    Probing, hashing and the load factor match the hash table; the slot metadata
+    matches the hash set.
+
+    Functions:
+    - Initialization (`ht_multi_init`) and cleanup (`ht_multi_free`).
+    - Append a value to a key (`ht_multi_add`).
+    - Get all values of a key as a contiguous span (`ht_multi_get`). The span is
+      valid until the next call that modifies the multimap.
+    - Remove one value (`ht_multi_remove`) or the key with all of its values (`ht_multi_delete`).
+    - Utility: number of slots (`ht_multi_size`) and number of keys (`ht_multi_count`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashmultimap.h"
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define HM_FULL(tag) ((uint8_t)(0x80 | (tag)))
+#define HM_TAG(hash_value) ((uint8_t)((hash_value) >> 25))
+#define HM_INITIAL_RUN 2
+
+static bool hm_alloc_slots(HashMultiMap *mm, size_t size) {
+    uint8_t *meta = calloc(size, sizeof(uint8_t));
+    HashMultiSlot *slots = malloc(size * sizeof(HashMultiSlot));
+
+    if(!meta || !slots) {
+        free(meta);
+        free(slots);
+        fputs("Cannot allocate a memory for hash multimap slots.\n", stderr);
+
+        return false;
+    }
+
+    mm->meta = meta;
+    mm->slots = slots;
+    mm->size = size;
+    mm->tombstone_count = 0;
+
+    return true;
+}
+
+static bool hm_rehash(HashMultiMap *mm, size_t new_size) {
+    uint8_t *old_meta = mm->meta;
+    HashMultiSlot *old_slots = mm->slots;
+    size_t old_size = mm->size;
+
+    if(!hm_alloc_slots(mm, new_size)) {
+        return false;
+    }
+
+    for(size_t i = 0; i < old_size; i++) {
+        if(old_meta[i] & 0x80) {
+            size_t index = ht_fnv1a(old_slots[i].key) % new_size;
+
+            while(mm->meta[index] != HM_EMPTY) {
+                index = (index + 1) % new_size;
+            }
+
+            mm->meta[index] = old_meta[i];
+            mm->slots[index] = old_slots[i];
+        }
+    }
+
+    free(old_meta);
+    free(old_slots);
+
+    return true;
+}
+
+// Returns the slot index of key, or SIZE_MAX if absent
+static size_t hm_find(HashMultiMap *mm, const char *key, uint32_t hash_value) {
+    uint8_t tag = HM_FULL(HM_TAG(hash_value));
+    size_t index = hash_value % mm->size;
+
+    while(mm->meta[index] != HM_EMPTY) {
+        if(mm->meta[index] == tag && strcmp(mm->slots[index].key, key) == 0) {
+            return index;
+        }
+
+        index = (index + 1) % mm->size;
+    }
+
+    return SIZE_MAX;
+}
+
+// Rewrites the arena with every live run packed from the start
+static bool hm_compact(HashMultiMap *mm) {
+    void **arena = malloc(mm->arena_capacity * sizeof(void *));
+    size_t used = 0;
+
+    if(!arena) {
+        return false;
+    }
+
+    for(size_t i = 0; i < mm->size; i++) {
+        if(mm->meta[i] & 0x80) {
+            HashMultiSlot *slot = &mm->slots[i];
+
+            memcpy(arena + used, mm->arena + slot->offset, slot->count * sizeof(void *));
+            slot->offset = used;
+            used += slot->capacity;
+        }
+    }
+
+    free(mm->arena);
+    mm->arena = arena;
+    mm->arena_used = used;
+    mm->arena_garbage = 0;
+
+    return true;
+}
+
+// Makes room for extra entries at the end of the arena
+static bool hm_reserve(HashMultiMap *mm, size_t extra) {
+    if(mm->arena_garbage > mm->arena_used / 2 && hm_compact(mm) && mm->arena_used + extra <= mm->arena_capacity) {
+        return true;
+    }
+
+    if(mm->arena_used + extra <= mm->arena_capacity) {
+        return true;
+    }
+
+    size_t capacity = mm->arena_capacity ? mm->arena_capacity : 16;
+
+    while(capacity < mm->arena_used + extra) {
+        if(capacity > SIZE_MAX / (2 * sizeof(void *))) {
+            fputs("Hash multimap arena cannot grow beyond maximum limit (SIZE_MAX).\n", stderr);
+            return false;
+        }
+
+        capacity *= 2;
+    }
+
+    void **arena = realloc(mm->arena, capacity * sizeof(void *));
+
+    if(!arena) {
+        fputs("Cannot allocate a memory for hash multimap values.\n", stderr);
+        return false;
+    }
+
+    mm->arena = arena;
+    mm->arena_capacity = capacity;
+
+    return true;
+}
+
+// Gives a full run room for at least one more value
+static bool hm_grow_run(HashMultiMap *mm, HashMultiSlot *slot) {
+    if(slot->capacity > UINT32_MAX / 2) {
+        fprintf(stderr, "Hash multimap key '%s' cannot hold more values.\n", slot->key);
+        return false;
+    }
+
+    // The last run in the arena can simply extend past its end
+    if(slot->offset + slot->capacity == mm->arena_used) {
+        if(!hm_reserve(mm, slot->capacity)) {
+            return false;
+        }
+
+        // Compaction may have reordered the runs, in which case the run has to move
+        if(slot->offset + slot->capacity == mm->arena_used) {
+            mm->arena_used += slot->capacity;
+            slot->capacity *= 2;
+
+            return true;
+        }
+    }
+
+    uint32_t capacity = slot->capacity * 2;
+
+    if(!hm_reserve(mm, capacity)) {
+        return false;
+    }
+
+    memcpy(mm->arena + mm->arena_used, mm->arena + slot->offset, slot->count * sizeof(void *));
+    mm->arena_garbage += slot->capacity;
+    slot->offset = mm->arena_used;
+    slot->capacity = capacity;
+    mm->arena_used += capacity;
+
+    return true;
+}
+
+bool ht_multi_add(HashMultiMap *mm, const char *key, void *value) {
+    if(!mm || mm->size == 0) {
+        fputs("Cannot add a value to an unallocated hash multimap.\n", stderr);
+        return false;
+    }
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return false;
+    }
+    else if(*key == '\0') {
+        fputs("Key cannot be an empty string.\n", stderr);
+        return false;
+    }
+
+    uint32_t hash_value = ht_fnv1a(key);
+    size_t index = mm->element_count > 0 ? hm_find(mm, key, hash_value) : SIZE_MAX;
+
+    if(index != SIZE_MAX) {
+        HashMultiSlot *slot = &mm->slots[index];
+
+        if(slot->count == slot->capacity && !hm_grow_run(mm, slot)) {
+            return false;
+        }
+
+        mm->arena[slot->offset + slot->count++] = value;
+
+        return true;
+    }
+
+    if((float)(mm->element_count + mm->tombstone_count + 1) / (float)mm->size > LOAD_FACTOR_THRESHOLD) {
+        size_t new_size = mm->size;
+
+        if((float)(mm->element_count + 1) / (float)mm->size > LOAD_FACTOR_THRESHOLD / 2) {
+            if(mm->size > SIZE_MAX / 2) {
+                fputs("Hash multimap resize failed: cannot double size beyond maximum limit (SIZE_MAX).\n", stderr);
+                return false;
+            }
+
+            new_size = mm->size * 2;
+        }
+
+        if(!hm_rehash(mm, new_size)) {
+            fprintf(stderr, "Hash multimap resize failed, cannot insert key '%s'.\n", key);
+            return false;
+        }
+    }
+
+    if(!hm_reserve(mm, HM_INITIAL_RUN)) {
+        return false;
+    }
+
+    index = hash_value % mm->size;
+
+    while(mm->meta[index] & 0x80) {
+        index = (index + 1) % mm->size;
+    }
+
+    if(mm->meta[index] == HM_TOMBSTONE) {
+        mm->tombstone_count--;
+    }
+
+    HashMultiSlot *slot = &mm->slots[index];
+
+    mm->meta[index] = HM_FULL(HM_TAG(hash_value));
+    slot->key = key;
+    slot->offset = mm->arena_used;
+    slot->count = 1;
+    slot->capacity = HM_INITIAL_RUN;
+    mm->arena[slot->offset] = value;
+    mm->arena_used += HM_INITIAL_RUN;
+    mm->element_count++;
+
+    return true;
+}
+
+void *const *ht_multi_get(HashMultiMap *mm, const char *key, size_t *count) {
+    if(count) {
+        *count = 0;
+    }
+
+    if(!mm || mm->element_count == 0 || !key || *key == '\0') {
+        return NULL;
+    }
+
+    size_t index = hm_find(mm, key, ht_fnv1a(key));
+
+    if(index == SIZE_MAX) {
+        return NULL;
+    }
+
+    if(count) {
+        *count = mm->slots[index].count;
+    }
+
+    return mm->arena + mm->slots[index].offset;
+}
+
+static void hm_delete_slot(HashMultiMap *mm, size_t index) {
+    mm->arena_garbage += mm->slots[index].capacity;
+    mm->meta[index] = HM_TOMBSTONE;
+    mm->tombstone_count++;
+    mm->element_count--;
+}
+
+bool ht_multi_remove(HashMultiMap *mm, const char *key, const void *value) {
+    if(!mm || mm->element_count == 0 || !key || *key == '\0') {
+        return false;
+    }
+
+    size_t index = hm_find(mm, key, ht_fnv1a(key));
+
+    if(index == SIZE_MAX) {
+        return false;
+    }
+
+    HashMultiSlot *slot = &mm->slots[index];
+    void **run = mm->arena + slot->offset;
+
+    for(uint32_t i = 0; i < slot->count; i++) {
+        if(run[i] == value) {
+            // Keep the remaining values in insertion order
+            memmove(run + i, run + i + 1, (slot->count - i - 1) * sizeof(void *));
+
+            if(--slot->count == 0) {
+                hm_delete_slot(mm, index);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ht_multi_delete(HashMultiMap *mm, const char *key) {
+    if(!mm || mm->element_count == 0 || !key || *key == '\0') {
+        return;
+    }
+
+    size_t index = hm_find(mm, key, ht_fnv1a(key));
+
+    if(index != SIZE_MAX) {
+        hm_delete_slot(mm, index);
+    }
+}
+
+void ht_multi_free(HashMultiMap **mm_ptr) {
+    if(!mm_ptr || !*mm_ptr) {
+        return;
+    }
+
+    HashMultiMap *mm = *mm_ptr;
+
+    free(mm->meta);
+    free(mm->slots);
+    free(mm->arena);
+    free(mm);
+    *mm_ptr = NULL;
+}
+
+size_t ht_multi_size(HashMultiMap *mm) {
+    if(!mm) {
+        fputs("Hash multimap is NULL.\n", stderr);
+        return 0;
+    }
+
+    return mm->size;
+}
+
+size_t ht_multi_count(HashMultiMap *mm) {
+    if(!mm) {
+        fputs("Hash multimap is NULL.\n", stderr);
+        return 0;
+    }
+
+    return mm->element_count;
+}
+
+HashMultiMap *ht_multi_init(size_t init_size) {
+    HashMultiMap *mm = malloc(sizeof(HashMultiMap));
+
+    if(!mm) {
+        fputs("Cannot allocate a memory for hash multimap struct.\n", stderr);
+        return NULL;
+    }
+
+    mm->element_count = 0;
+    mm->arena = NULL;
+    mm->arena_used = 0;
+    mm->arena_capacity = 0;
+    mm->arena_garbage = 0;
+
+    if(!hm_alloc_slots(mm, init_size == 0 ? 1 : init_size)) {
+        free(mm);
+        return NULL;
+    }
+
+    return mm;
+}
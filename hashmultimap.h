@@ -0,0 +1,39 @@
+#ifndef HASH_MULTI_MAP_H
+#define HASH_MULTI_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HM_EMPTY 0x00
+#define HM_TOMBSTONE 0x01
+
+typedef struct {
+    const char *key;
+    size_t offset;     // start of the key's value run in the arena
+    uint32_t count;    // values stored in the run
+    uint32_t capacity; // values the run can hold before it must move
+} HashMultiSlot;
+
+typedef struct HashMultiMap {
+    size_t size;
+    size_t element_count;
+    size_t tombstone_count;
+    uint8_t *meta;     // HM_EMPTY, HM_TOMBSTONE or 0x80 | 7 bits of the key's hash
+    HashMultiSlot *slots;
+    void **arena;      // value runs of all keys, each contiguous
+    size_t arena_used;
+    size_t arena_capacity;
+    size_t arena_garbage; // arena entries left behind by runs that moved or were deleted
+} HashMultiMap;
+
+bool ht_multi_add(HashMultiMap *mm, const char *key, void *value);
+void *const *ht_multi_get(HashMultiMap *mm, const char *key, size_t *count);
+bool ht_multi_remove(HashMultiMap *mm, const char *key, const void *value);
+void ht_multi_delete(HashMultiMap *mm, const char *key);
+void ht_multi_free(HashMultiMap **mm_ptr);
+size_t ht_multi_size(HashMultiMap *mm);
+size_t ht_multi_count(HashMultiMap *mm);
+HashMultiMap *ht_multi_init(size_t init_size);
+
+#endif
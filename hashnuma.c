@@ -0,0 +1,299 @@
+/*
+    NUMA Placement
+    
+    Description:
+    Applies an explicit NUMA memory policy to freshly mapped slot arrays and tells
+    callers which node they are running on. Policies are applied with the raw `mbind`
+    system call, so the library needs neither libnuma nor its headers.
+
+    The policy is set before the pages are touched, so the kernel allocates every page
+    on first touch according to it, spreading them over every node (interleave) or
+    keeping them on one node (bind). On machines or kernels without NUMA support the
+    policy cannot be applied, and the mapping is used as ordinary memory.
+
+    Node and CPU topology is read once from sysfs. The current node is looked up from
+    the CPU the caller runs on, which `sched_getcpu` answers without a system call on
+    current kernels.
+
+    Node arenas hand out small blocks (the slots of bound tables and the keys their
+    owners copy into them) from chunks bound to one node, so that everything a lookup
+    touches stays on that node. Blocks are kept on one free list per power-of-two size
+    class and reused; chunks go back to the system only when the arena is destroyed.
+    Blocks larger than the biggest class get a mapping of their own. An arena is not
+    synchronized.
+*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define HT_NUMA_MAX_NODES 1024
+#define HT_NUMA_MAX_CPUS 4096
+#define HT_MPOL_BIND 2
+#define HT_MPOL_INTERLEAVE 3
+
+#define HT_MASK_BITS (8 * sizeof(unsigned long))
+
+#define HT_ARENA_CHUNK ((size_t)1 << 20)
+#define HT_ARENA_MIN_BLOCK 16
+#define HT_ARENA_CLASSES 9 // 16 bytes to 4 KiB
+
+// Heads every chunk and every large block, so that ht_node_arena_destroy can unmap them
+typedef struct HashArenaChunk {
+    struct HashArenaChunk *next;
+    struct HashArenaChunk *prev;
+    size_t bytes;
+    size_t reserved;           // keeps the blocks that follow 16-byte aligned
+} HashArenaChunk;
+
+typedef struct HashArenaBlock {
+    struct HashArenaBlock *next;
+} HashArenaBlock;
+
+struct HashNodeArena {
+    unsigned node;
+    HashArenaChunk *chunks;    // chunks and large blocks, newest first
+    char *cursor;              // unused tail of the newest chunk
+    char *end;
+    HashArenaBlock *free_blocks[HT_ARENA_CLASSES];
+};
+
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+static unsigned long online_nodes[HT_NUMA_MAX_NODES / HT_MASK_BITS];
+static unsigned node_count = 1;
+static short cpu_node[HT_NUMA_MAX_CPUS];
+
+// Parses a sysfs list such as "0-3,8,10-11" and sets its members in mask; returns the highest member or -1
+static int parse_list(const char *path, unsigned long *mask, size_t max) {
+    FILE *file = fopen(path, "r");
+    int highest = -1;
+
+    if(!file) {
+        return -1;
+    }
+
+    unsigned first, last;
+    char separator;
+
+    while(fscanf(file, "%u", &first) == 1) {
+        last = first;
+
+        if(fscanf(file, "%c", &separator) == 1 && separator == '-') {
+            if(fscanf(file, "%u", &last) != 1) {
+                break;
+            }
+
+            if(fscanf(file, "%c", &separator) != 1) {
+                separator = '\n';
+            }
+        }
+
+        for(unsigned i = first; i <= last && i < max; i++) {
+            mask[i / HT_MASK_BITS] |= 1UL << (i % HT_MASK_BITS);
+            highest = (int)i > highest ? (int)i : highest;
+        }
+
+        if(separator != ',') {
+            break;
+        }
+    }
+
+    fclose(file);
+
+    return highest;
+}
+
+static void read_topology(void) {
+    int highest = parse_list("/sys/devices/system/node/online", online_nodes, HT_NUMA_MAX_NODES);
+
+    if(highest < 0) {
+        online_nodes[0] = 1;
+        return;
+    }
+
+    node_count = (unsigned)highest + 1;
+
+    for(unsigned node = 0; node < node_count; node++) {
+        unsigned long cpus[HT_NUMA_MAX_CPUS / HT_MASK_BITS] = {0};
+        char path[64];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+
+        if(parse_list(path, cpus, HT_NUMA_MAX_CPUS) < 0) {
+            continue;
+        }
+
+        for(unsigned cpu = 0; cpu < HT_NUMA_MAX_CPUS; cpu++) {
+            if(cpus[cpu / HT_MASK_BITS] & (1UL << (cpu % HT_MASK_BITS))) {
+                cpu_node[cpu] = (short)node;
+            }
+        }
+    }
+}
+
+unsigned ht_numa_node_count(void) {
+    pthread_once(&topology_once, read_topology);
+
+    return node_count;
+}
+
+unsigned ht_numa_current_node(void) {
+    pthread_once(&topology_once, read_topology);
+
+    int cpu = sched_getcpu();
+
+    return cpu >= 0 && cpu < HT_NUMA_MAX_CPUS ? (unsigned)cpu_node[cpu] : 0;
+}
+
+bool ht_numa_place(void *ptr, size_t bytes, int policy, unsigned node) {
+    pthread_once(&topology_once, read_topology);
+
+    unsigned long mask[HT_NUMA_MAX_NODES / HT_MASK_BITS] = {0};
+    int mode = HT_MPOL_INTERLEAVE;
+
+    if(policy == HT_NUMA_BIND) {
+        mask[node / HT_MASK_BITS] = 1UL << (node % HT_MASK_BITS);
+        mode = HT_MPOL_BIND;
+    }
+    else {
+        memcpy(mask, online_nodes, sizeof(mask));
+    }
+
+    return syscall(SYS_mbind, ptr, bytes, mode, mask, (unsigned long)HT_NUMA_MAX_NODES + 1, 0U) == 0;
+}
+
+HashNodeArena *ht_node_arena_create(unsigned node) {
+    HashNodeArena *arena = calloc(1, sizeof(HashNodeArena));
+
+    if(!arena) {
+        fputs("Cannot allocate a memory for NUMA node arena.\n", stderr);
+        return NULL;
+    }
+
+    arena->node = node;
+
+    return arena;
+}
+
+static unsigned size_class(size_t bytes) {
+    unsigned class = 0;
+
+    while(((size_t)HT_ARENA_MIN_BLOCK << class) < bytes) {
+        class++;
+    }
+
+    return class;
+}
+
+// Maps and binds a chunk of at least bytes after its header and links it in
+static HashArenaChunk *map_chunk(HashNodeArena *arena, size_t bytes) {
+    size_t total = (sizeof(HashArenaChunk) + bytes + HT_ARENA_CHUNK - 1) / HT_ARENA_CHUNK * HT_ARENA_CHUNK;
+    HashArenaChunk *chunk = ht_pages_alloc(total, false);
+
+    if(!chunk) {
+        return NULL;
+    }
+
+    // Bound before the first write, so that every page is allocated on the node
+    ht_numa_place(chunk, total, HT_NUMA_BIND, arena->node);
+    chunk->bytes = total;
+    chunk->prev = NULL;
+    chunk->next = arena->chunks;
+
+    if(arena->chunks) {
+        arena->chunks->prev = chunk;
+    }
+
+    arena->chunks = chunk;
+
+    return chunk;
+}
+
+static void unmap_chunk(HashNodeArena *arena, HashArenaChunk *chunk) {
+    if(chunk->prev) {
+        chunk->prev->next = chunk->next;
+    }
+    else {
+        arena->chunks = chunk->next;
+    }
+
+    if(chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
+
+    ht_pages_free(chunk, chunk->bytes, false);
+}
+
+void *ht_node_arena_alloc(HashNodeArena *arena, size_t bytes) {
+    unsigned class = size_class(bytes);
+
+    if(class >= HT_ARENA_CLASSES) {
+        HashArenaChunk *chunk = map_chunk(arena, bytes);
+
+        return chunk ? chunk + 1 : NULL;
+    }
+
+    HashArenaBlock *block = arena->free_blocks[class];
+
+    if(block) {
+        arena->free_blocks[class] = block->next;
+        return block;
+    }
+
+    size_t block_size = (size_t)HT_ARENA_MIN_BLOCK << class;
+
+    if((size_t)(arena->end - arena->cursor) < block_size) {
+        HashArenaChunk *chunk = map_chunk(arena, HT_ARENA_CHUNK - sizeof(HashArenaChunk));
+
+        if(!chunk) {
+            return NULL;
+        }
+
+        arena->cursor = (char *)(chunk + 1);
+        arena->end = (char *)chunk + chunk->bytes;
+    }
+
+    block = (HashArenaBlock *)arena->cursor;
+    arena->cursor += block_size;
+
+    return block;
+}
+
+// bytes must be the size the block was allocated with
+void ht_node_arena_free(HashNodeArena *arena, void *ptr, size_t bytes) {
+    unsigned class = size_class(bytes);
+
+    if(!ptr) {
+        return;
+    }
+    else if(class >= HT_ARENA_CLASSES) {
+        unmap_chunk(arena, (HashArenaChunk *)ptr - 1);
+        return;
+    }
+
+    HashArenaBlock *block = ptr;
+
+    block->next = arena->free_blocks[class];
+    arena->free_blocks[class] = block;
+}
+
+void ht_node_arena_destroy(HashNodeArena *arena) {
+    if(!arena) {
+        return;
+    }
+
+    while(arena->chunks) {
+        unmap_chunk(arena, arena->chunks);
+    }
+
+    free(arena);
+}
@@ -0,0 +1,91 @@
+/*
+    Slot Array Pages
+    
+    Description:
+    Allocates slot arrays directly from the kernel, for tables whose arrays need a
+    particular page size or NUMA placement. Memory comes straight from `mmap`, so it
+    is zeroed and no page has been touched yet when the caller gets it.
+
+    Large tables probe random slots, so with 4 KiB pages nearly every lookup needs a
+    TLB entry of its own. Huge-page arrays cover 2 MiB per TLB entry instead. They
+    are tried in this order:
+    - Explicit huge pages (`MAP_HUGETLB`), available when the administrator has
+      reserved a hugetlbfs pool.
+    - Transparent huge pages: a 2 MiB aligned mapping marked with
+      `madvise(MADV_HUGEPAGE)`, which the kernel backs with huge pages when it can.
+      If transparent huge pages are disabled, the mapping simply uses regular pages.
+
+    Huge-page arrays are rounded up to a whole number of huge pages.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "hashtable_internal.h"
+
+static size_t mapped_bytes(size_t bytes, bool huge) {
+    return huge ? (bytes + HT_HUGE_PAGE_SIZE - 1) / HT_HUGE_PAGE_SIZE * HT_HUGE_PAGE_SIZE : bytes;
+}
+
+static void *map_anonymous(size_t bytes, int flags) {
+    void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+// Maps bytes at a huge page boundary, so that the whole range can be backed by huge pages
+static void *map_aligned(size_t bytes) {
+    char *ptr = map_anonymous(bytes + HT_HUGE_PAGE_SIZE, 0);
+
+    if(!ptr) {
+        return NULL;
+    }
+
+    char *aligned = (char *)(((uintptr_t)ptr + HT_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HT_HUGE_PAGE_SIZE - 1));
+    size_t head = aligned - ptr;
+
+    if(head > 0) {
+        munmap(ptr, head);
+    }
+
+    munmap(aligned + bytes, HT_HUGE_PAGE_SIZE - head);
+
+    return aligned;
+}
+
+void *ht_pages_alloc(size_t bytes, bool huge) {
+    if(bytes > SIZE_MAX - 2 * HT_HUGE_PAGE_SIZE) {
+        return NULL;
+    }
+    else if(!huge) {
+        return map_anonymous(bytes, 0);
+    }
+
+    bytes = mapped_bytes(bytes, true);
+
+#ifdef MAP_HUGETLB
+    void *ptr = map_anonymous(bytes, MAP_HUGETLB);
+
+    if(ptr) {
+        return ptr;
+    }
+#endif
+
+    void *aligned = map_aligned(bytes);
+
+#ifdef MADV_HUGEPAGE
+    if(aligned) {
+        madvise(aligned, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return aligned;
+}
+
+void ht_pages_free(void *ptr, size_t bytes, bool huge) {
+    if(ptr) {
+        munmap(ptr, mapped_bytes(bytes, huge));
+    }
+}
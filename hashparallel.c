@@ -0,0 +1,71 @@
+/*
+    Parallel Task Runner
+    
+    Description:
+    Runs one task on a number of workers and waits for all of them, for the table
+    operations that split large arrays into ranges (parallel resize, bulk build).
+    Worker 0 runs on the calling thread; the others get a thread of their own for the
+    duration of the call. The operations that use this are rare and large, so starting
+    threads per call costs little next to the work itself and leaves no idle pool behind.
+
+    If a thread cannot be started, its share of the work runs on the calling thread
+    instead, so a task always sees every worker index exactly once.
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "hashtable_internal.h"
+
+typedef struct {
+    HashParallelTask task;
+    void *ctx;
+    unsigned worker;
+    unsigned workers;
+} HashParallelWorker;
+
+static void *run_worker(void *arg) {
+    HashParallelWorker *worker = arg;
+
+    worker->task(worker->ctx, worker->worker, worker->workers);
+
+    return NULL;
+}
+
+unsigned ht_parallel_cpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cpus > 0 ? (unsigned)cpus : 1;
+}
+
+void ht_parallel_run(unsigned workers, HashParallelTask task, void *ctx) {
+    if(workers <= 1) {
+        task(ctx, 0, 1);
+        return;
+    }
+
+    HashParallelWorker *args = malloc(workers * sizeof(HashParallelWorker));
+    pthread_t *threads = malloc(workers * sizeof(pthread_t));
+    bool *started = calloc(workers, sizeof(bool));
+
+    for(unsigned i = 1; args && threads && started && i < workers; i++) {
+        args[i] = (HashParallelWorker){task, ctx, i, workers};
+        started[i] = pthread_create(&threads[i], NULL, run_worker, &args[i]) == 0;
+    }
+
+    task(ctx, 0, workers);
+
+    for(unsigned i = 1; i < workers; i++) {
+        if(started && started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        else {
+            task(ctx, i, workers);
+        }
+    }
+
+    free(args);
+    free(threads);
+    free(started);
+}
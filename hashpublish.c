@@ -0,0 +1,152 @@
+/*
+    RCU-Style Snapshot Publication
+    
+    Description:
+    For read-mostly maps that are rebuilt wholesale (e.g. routing tables), a publisher
+    holds one immutable snapshot that any number of threads read without locks.
+
+    - The writer builds the next version off to the side as an ordinary hash table,
+      either from scratch with `ht_init`/`ht_set` or by starting from a copy of the
+      current snapshot (`ht_publisher_clone`).
+    - `ht_publish` swaps the readers' view to the new table with a single atomic
+      pointer store. The previous table is freed with `ht_free` after a grace period,
+      once every reader that could still be using it has finished. Publishing also
+      reclaims right away: when no reader is inside a lookup, the previous table is
+      freed before `ht_publish` returns, otherwise by a later publish. Old tables are
+      never left waiting for a batch of retirements. `ht_publish_sync` waits out the
+      grace period instead, so the previous table is always freed when it returns.
+    - Readers bracket their lookups with epoch-based reclamation, which only writes
+      the reader's own per-thread record. `ht_published_get` and friends do this for a
+      single lookup. `ht_snapshot_acquire`/`ht_snapshot_release` keep one snapshot
+      stable across several lookups.
+
+    Once a table has been published it must not be modified; only the hash table's
+    read functions may be used on a snapshot. Values and keys stay owned by the caller
+    and must outlive every snapshot that refers to them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hashpublish.h"
+#include "hashtable_internal.h"
+
+static void destroy_table(void *ptr) {
+    HashTable *ht = ptr;
+
+    ht_free(&ht);
+}
+
+bool ht_publish(HashPublisher *pub, HashTable *next) {
+    if(!pub || !next) {
+        fputs("Cannot publish an unallocated hash table.\n", stderr);
+        return false;
+    }
+
+    HashTable *previous = atomic_exchange_explicit(&pub->current, next, memory_order_acq_rel);
+
+    if(previous && previous != next) {
+        ht_epoch_retire(previous, destroy_table);
+        ht_epoch_reclaim();
+    }
+
+    return true;
+}
+
+// Must not be called between ht_snapshot_acquire and ht_snapshot_release
+bool ht_publish_sync(HashPublisher *pub, HashTable *next) {
+    if(!ht_publish(pub, next)) {
+        return false;
+    }
+
+    ht_epoch_synchronize();
+
+    return true;
+}
+
+HashTable *ht_publisher_clone(HashPublisher *pub) {
+    if(!pub) {
+        fputs("Hash table publisher is NULL.\n", stderr);
+        return NULL;
+    }
+
+    HashTable *snapshot = ht_snapshot_acquire(pub);
+    HashTable *copy = ht_init(snapshot ? snapshot->size : 1);
+
+    if(copy && snapshot) {
+        for(size_t i = 0; i < snapshot->size; i++) {
+            HashSlot *slot = snapshot->table[i];
+
+            if(slot && slot != TOMBSTONE && !ht_set(copy, slot->key, slot->value)) {
+                ht_free(&copy);
+                break;
+            }
+        }
+    }
+
+    ht_snapshot_release(pub);
+
+    return copy;
+}
+
+HashTable *ht_snapshot_acquire(HashPublisher *pub) {
+    ht_epoch_enter();
+
+    return atomic_load_explicit(&pub->current, memory_order_acquire);
+}
+
+void ht_snapshot_release(HashPublisher *pub) {
+    (void)pub;
+    ht_epoch_exit();
+}
+
+const void *ht_published_get(HashPublisher *pub, const char *key) {
+    void *value = NULL;
+
+    ht_published_try_get(pub, key, &value);
+
+    return value;
+}
+
+bool ht_published_try_get(HashPublisher *pub, const char *key, void **out) {
+    if(!pub) {
+        return false;
+    }
+
+    HashTable *snapshot = ht_snapshot_acquire(pub);
+    bool found = snapshot && ht_try_get(snapshot, key, out);
+
+    ht_snapshot_release(pub);
+
+    return found;
+}
+
+bool ht_published_has(HashPublisher *pub, const char *key) {
+    return ht_published_try_get(pub, key, NULL);
+}
+
+void ht_publisher_free(HashPublisher **pub_ptr) {
+    if(!pub_ptr || !*pub_ptr) {
+        return;
+    }
+
+    HashPublisher *pub = *pub_ptr;
+    HashTable *current = atomic_load(&pub->current);
+
+    ht_free(&current);
+    free(pub);
+    *pub_ptr = NULL;
+}
+
+HashPublisher *ht_publisher_init(HashTable *initial) {
+    HashPublisher *pub = malloc(sizeof(HashPublisher));
+
+    if(!pub) {
+        fputs("Cannot allocate a memory for hash table publisher.\n", stderr);
+        return NULL;
+    }
+
+    atomic_init(&pub->current, initial);
+
+    return pub;
+}
@@ -0,0 +1,24 @@
+#ifndef HASH_PUBLISH_H
+#define HASH_PUBLISH_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "hashtable.h"
+
+typedef struct HashPublisher {
+    _Atomic(HashTable *) current; // the snapshot readers see; never modified once published
+} HashPublisher;
+
+bool ht_publish(HashPublisher *pub, HashTable *next);
+bool ht_publish_sync(HashPublisher *pub, HashTable *next);
+HashTable *ht_publisher_clone(HashPublisher *pub);
+HashTable *ht_snapshot_acquire(HashPublisher *pub);
+void ht_snapshot_release(HashPublisher *pub);
+const void *ht_published_get(HashPublisher *pub, const char *key);
+bool ht_published_try_get(HashPublisher *pub, const char *key, void **out);
+bool ht_published_has(HashPublisher *pub, const char *key);
+void ht_publisher_free(HashPublisher **pub_ptr);
+HashPublisher *ht_publisher_init(HashTable *initial);
+
+#endif
@@ -0,0 +1,198 @@
+/*
+    NUMA Read Replicas
+    
+    Description:
+    For read-mostly tables on multi-socket machines, keeps one full copy of the table
+    per NUMA node. Each replica is bound to its node: its slot array, its slots and
+    its own copy of every key live in that node's memory. Reads go to the replica of
+    the node the calling thread runs on, so a lookup touches local memory for
+    everything but the value, which stays wherever the caller put it. Writes are
+    applied to every replica, which makes them cost one insertion per node.
+
+    Before a write touches any replica, every replica is grown to hold one more entry,
+    so no insertion in the write can resize. Updating an existing key then allocates
+    nothing and cannot fail; inserting a new key can only fail to allocate its slot or
+    key copy, and is undone by deleting it from the replicas that already have it,
+    which allocates nothing either. The replicas therefore never disagree about a key.
+
+    On a machine with a single node there is one replica, keys are not copied (they
+    must outlive the table, as with the hash table itself), and every call goes
+    straight to it.
+
+    Like the hash table itself, a replicated table is not synchronized: concurrent
+    writers, or writers next to readers, need an external lock.
+
+    Functions:
+    - Initialization (`ht_replicated_init`): creates one replica of `init_size` slots per node.
+    - Insertion, retrieval, deletion and existence check (`ht_replicated_set`,
+      `ht_replicated_get`, `ht_replicated_try_get`, `ht_replicated_delete`,
+      `ht_replicated_has`).
+    - Number of elements (`ht_replicated_count`).
+    - Memory management (`ht_replicated_free`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashreplica.h"
+#include "hashtable_internal.h"
+
+static HashTable *local_replica(ReplicatedHashTable *rht) {
+    unsigned node = rht->replica_count > 1 ? ht_numa_current_node() : 0;
+
+    return rht->replicas[node < rht->replica_count ? node : 0];
+}
+
+// Copies key into the replica's node arena; replicas without one store the caller's key
+static const char *copy_key(HashTable *replica, const char *key) {
+    if(!replica->arena) {
+        return key;
+    }
+
+    size_t bytes = strlen(key) + 1;
+    char *copy = ht_node_arena_alloc(replica->arena, bytes);
+
+    if(!copy) {
+        fputs("Cannot allocate a memory for replica key.\n", stderr);
+        return NULL;
+    }
+
+    memcpy(copy, key, bytes);
+
+    return copy;
+}
+
+static void free_key(HashTable *replica, const char *stored) {
+    if(replica->arena && stored) {
+        ht_node_arena_free(replica->arena, (void *)stored, strlen(stored) + 1);
+    }
+}
+
+static void remove_key(HashTable *replica, const char *key) {
+    const char *stored = ht_stored_key(replica, key);
+
+    if(stored) {
+        ht_delete(replica, key);
+        free_key(replica, stored);
+    }
+}
+
+bool ht_replicated_set(ReplicatedHashTable *rht, const char *key, void *value) {
+    if(!rht) {
+        fputs("Cannot set a value for an unallocated replicated hash table.\n", stderr);
+        return false;
+    }
+    else if(!key || *key == '\0') {
+        return ht_set(rht->replicas[0], key, value); // reports the bad key
+    }
+
+    bool existed = ht_has(rht->replicas[0], key);
+
+    // Growing changes no contents, so a failure here leaves every replica as it was
+    for(size_t i = 0; i < rht->replica_count; i++) {
+        if(!ht_reserve(rht->replicas[i], ht_count(rht->replicas[i]) + 1)) {
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < rht->replica_count; i++) {
+        const char *stored = existed ? key : copy_key(rht->replicas[i], key);
+
+        if(stored && ht_set(rht->replicas[i], stored, value)) {
+            continue;
+        }
+
+        // Updates cannot fail once grown, so this is a new key, and deleting it allocates nothing
+        if(stored) {
+            free_key(rht->replicas[i], stored);
+        }
+
+        for(size_t j = 0; j < i; j++) {
+            remove_key(rht->replicas[j], key);
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+const void *ht_replicated_get(ReplicatedHashTable *rht, const char *key) {
+    return rht ? ht_get(local_replica(rht), key) : NULL;
+}
+
+bool ht_replicated_try_get(ReplicatedHashTable *rht, const char *key, void **out) {
+    return rht && ht_try_get(local_replica(rht), key, out);
+}
+
+void ht_replicated_delete(ReplicatedHashTable *rht, const char *key) {
+    if(!rht) {
+        return;
+    }
+
+    for(size_t i = 0; i < rht->replica_count; i++) {
+        remove_key(rht->replicas[i], key);
+    }
+}
+
+bool ht_replicated_has(ReplicatedHashTable *rht, const char *key) {
+    return rht && ht_has(local_replica(rht), key);
+}
+
+void ht_replicated_free(ReplicatedHashTable **rht_ptr) {
+    if(!rht_ptr || !*rht_ptr) {
+        return;
+    }
+
+    ReplicatedHashTable *rht = *rht_ptr;
+
+    for(size_t i = 0; i < rht->replica_count; i++) {
+        ht_free(&rht->replicas[i]);
+    }
+
+    free(rht->replicas);
+    free(rht);
+    *rht_ptr = NULL;
+}
+
+size_t ht_replicated_count(ReplicatedHashTable *rht) {
+    if(!rht) {
+        fputs("Replicated hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return ht_count(rht->replicas[0]);
+}
+
+ReplicatedHashTable *ht_replicated_init(size_t init_size) {
+    ReplicatedHashTable *rht = malloc(sizeof(ReplicatedHashTable));
+
+    if(!rht) {
+        fputs("Cannot allocate a memory for replicated hash table struct.\n", stderr);
+        return NULL;
+    }
+
+    rht->replica_count = ht_numa_node_count();
+    rht->replicas = calloc(rht->replica_count, sizeof(HashTable *));
+
+    if(!rht->replicas) {
+        free(rht);
+        fputs("Cannot allocate a memory for replicated hash table replicas.\n", stderr);
+
+        return NULL;
+    }
+
+    for(size_t i = 0; i < rht->replica_count; i++) {
+        HashNumaPolicy policy = rht->replica_count > 1 ? HT_NUMA_BIND : HT_NUMA_DEFAULT;
+
+        rht->replicas[i] = ht_init_numa(init_size, policy, (unsigned)i);
+
+        if(!rht->replicas[i]) {
+            ht_replicated_free(&rht);
+            return NULL;
+        }
+    }
+
+    return rht;
+}
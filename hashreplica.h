@@ -0,0 +1,23 @@
+#ifndef HASH_REPLICA_H
+#define HASH_REPLICA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hashtable.h"
+
+typedef struct ReplicatedHashTable {
+    size_t replica_count; // one per NUMA node
+    HashTable **replicas; // replicas[n] keeps its slots and key copies on node n
+} ReplicatedHashTable;
+
+bool ht_replicated_set(ReplicatedHashTable *rht, const char *key, void *value);
+const void *ht_replicated_get(ReplicatedHashTable *rht, const char *key);
+bool ht_replicated_try_get(ReplicatedHashTable *rht, const char *key, void **out);
+void ht_replicated_delete(ReplicatedHashTable *rht, const char *key);
+bool ht_replicated_has(ReplicatedHashTable *rht, const char *key);
+void ht_replicated_free(ReplicatedHashTable **rht_ptr);
+size_t ht_replicated_count(ReplicatedHashTable *rht);
+ReplicatedHashTable *ht_replicated_init(size_t init_size);
+
+#endif
@@ -0,0 +1,314 @@
+/*
+    Open Addressing Hash Set
+    
+    Description:
+    A key-only companion to the hash table for membership tests (e.g. deduplication).
+    Slots hold only a key pointer and one metadata byte, with no value pointer and no
+    per-entry allocation, so a slot costs 9 bytes instead of a pointer plus a heap
+    allocated `HashSlot`. The metadata byte stores 7 bits of the key's hash, which
+    lets probing skip most `strcmp` calls.
+
+    It uses the same FNV-1a hash, linear probing and load factor as the hash table.
+
+    Functions:
+    - Initialization (`hs_init`), insertion (`hs_add`), membership (`hs_contains`),
+      deletion (`hs_remove`) and cleanup (`hs_free`).
+    - Set operations (`hs_union`, `hs_intersect`, `hs_difference`) that build a new
+      set with linear passes over the slot arrays of both operands.
+    - Utility: number of slots (`hs_size`) and number of keys (`hs_count`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashset.h"
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+#define HS_FULL(tag) ((uint8_t)(0x80 | (tag)))
+#define HS_TAG(hash_value) ((uint8_t)((hash_value) >> 25))
+
+static bool hs_alloc_slots(HashSet *hs, size_t size) {
+    uint8_t *meta = calloc(size, sizeof(uint8_t));
+    const char **keys = malloc(size * sizeof(const char *));
+
+    if(!meta || !keys) {
+        free(meta);
+        free(keys);
+        fputs("Cannot allocate a memory for hash set slots.\n", stderr);
+
+        return false;
+    }
+
+    hs->meta = meta;
+    hs->keys = keys;
+    hs->size = size;
+    hs->tombstone_count = 0;
+
+    return true;
+}
+
+// Rehash every key into a fresh slot array of new_size slots, dropping tombstones
+static bool hs_rehash(HashSet *hs, size_t new_size) {
+    uint8_t *old_meta = hs->meta;
+    const char **old_keys = hs->keys;
+    size_t old_size = hs->size;
+
+    if(!hs_alloc_slots(hs, new_size)) {
+        return false;
+    }
+
+    for(size_t i = 0; i < old_size; i++) {
+        if(old_meta[i] & 0x80) {
+            uint32_t hash_value = ht_fnv1a(old_keys[i]);
+            size_t index = hash_value % new_size;
+
+            while(hs->meta[index] != HS_EMPTY) {
+                index = (index + 1) % new_size;
+            }
+
+            hs->meta[index] = HS_FULL(HS_TAG(hash_value));
+            hs->keys[index] = old_keys[i];
+        }
+    }
+
+    free(old_meta);
+    free(old_keys);
+
+    return true;
+}
+
+// Returns the slot index of key, or SIZE_MAX if absent
+static size_t hs_find(HashSet *hs, const char *key, uint32_t hash_value) {
+    uint8_t tag = HS_FULL(HS_TAG(hash_value));
+    size_t index = hash_value % hs->size;
+
+    while(hs->meta[index] != HS_EMPTY) {
+        if(hs->meta[index] == tag && strcmp(hs->keys[index], key) == 0) {
+            return index;
+        }
+
+        index = (index + 1) % hs->size;
+    }
+
+    return SIZE_MAX;
+}
+
+bool hs_add(HashSet *hs, const char *key) {
+    if(!hs || hs->size == 0) {
+        fputs("Cannot add a key to an unallocated hash set.\n", stderr);
+        return false;
+    }
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return false;
+    }
+    else if(*key == '\0') {
+        fputs("Key cannot be an empty string.\n", stderr);
+        return false;
+    }
+
+    uint32_t hash_value = ht_fnv1a(key);
+
+    if(hs->element_count > 0 && hs_find(hs, key, hash_value) != SIZE_MAX) {
+        return true;
+    }
+
+    // Tombstones count towards the load so that probe sequences always end at an empty slot
+    if((float)(hs->element_count + hs->tombstone_count + 1) / (float)hs->size > LOAD_FACTOR_THRESHOLD) {
+        size_t new_size = hs->size;
+
+        if((float)(hs->element_count + 1) / (float)hs->size > LOAD_FACTOR_THRESHOLD / 2) {
+            if(hs->size > SIZE_MAX / 2) {
+                fputs("Hash set resize failed: cannot double size beyond maximum limit (SIZE_MAX).\n", stderr);
+                return false;
+            }
+
+            new_size = hs->size * 2;
+        }
+
+        if(!hs_rehash(hs, new_size)) {
+            fprintf(stderr, "Hash set resize failed, cannot insert key '%s'.\n", key);
+            return false;
+        }
+    }
+
+    size_t index = hash_value % hs->size;
+
+    while(hs->meta[index] & 0x80) {
+        index = (index + 1) % hs->size;
+    }
+
+    if(hs->meta[index] == HS_TOMBSTONE) {
+        hs->tombstone_count--;
+    }
+
+    hs->meta[index] = HS_FULL(HS_TAG(hash_value));
+    hs->keys[index] = key;
+    hs->element_count++;
+
+    return true;
+}
+
+bool hs_contains(HashSet *hs, const char *key) {
+    if(!hs || hs->element_count == 0 || !key || *key == '\0') {
+        return false;
+    }
+
+    return hs_find(hs, key, ht_fnv1a(key)) != SIZE_MAX;
+}
+
+void hs_remove(HashSet *hs, const char *key) {
+    if(!hs || hs->element_count == 0 || !key || *key == '\0') {
+        return;
+    }
+
+    size_t index = hs_find(hs, key, ht_fnv1a(key));
+
+    if(index == SIZE_MAX) {
+        return;
+    }
+
+    hs->meta[index] = HS_TOMBSTONE;
+    hs->tombstone_count++;
+    hs->element_count--;
+}
+
+// Adds every key of src to dst, optionally filtered by membership in other
+static bool hs_add_all(HashSet *dst, HashSet *src, HashSet *other, bool keep_if_member) {
+    for(size_t i = 0; i < src->size; i++) {
+        if(!(src->meta[i] & 0x80)) {
+            continue;
+        }
+
+        if(other && hs_contains(other, src->keys[i]) != keep_if_member) {
+            continue;
+        }
+
+        if(!hs_add(dst, src->keys[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Presize so that n keys stay below the load factor threshold
+static HashSet *hs_init_for(size_t n) {
+    return hs_init((size_t)((double)n / LOAD_FACTOR_THRESHOLD) + 1);
+}
+
+HashSet *hs_union(HashSet *a, HashSet *b) {
+    if(!a || !b) {
+        fputs("Cannot compute the union of an unallocated hash set.\n", stderr);
+        return NULL;
+    }
+
+    HashSet *result = hs_init_for(a->element_count + b->element_count);
+
+    if(!result) {
+        return NULL;
+    }
+
+    if(!hs_add_all(result, a, NULL, true) || !hs_add_all(result, b, NULL, true)) {
+        hs_free(&result);
+    }
+
+    return result;
+}
+
+HashSet *hs_intersect(HashSet *a, HashSet *b) {
+    if(!a || !b) {
+        fputs("Cannot compute the intersection of an unallocated hash set.\n", stderr);
+        return NULL;
+    }
+
+    // Walk the smaller set and probe the larger one
+    if(b->element_count < a->element_count) {
+        HashSet *tmp = a;
+
+        a = b;
+        b = tmp;
+    }
+
+    HashSet *result = hs_init_for(a->element_count);
+
+    if(!result) {
+        return NULL;
+    }
+
+    if(!hs_add_all(result, a, b, true)) {
+        hs_free(&result);
+    }
+
+    return result;
+}
+
+HashSet *hs_difference(HashSet *a, HashSet *b) {
+    if(!a || !b) {
+        fputs("Cannot compute the difference of an unallocated hash set.\n", stderr);
+        return NULL;
+    }
+
+    HashSet *result = hs_init_for(a->element_count);
+
+    if(!result) {
+        return NULL;
+    }
+
+    if(!hs_add_all(result, a, b, false)) {
+        hs_free(&result);
+    }
+
+    return result;
+}
+
+void hs_free(HashSet **hs_ptr) {
+    if(!hs_ptr || !*hs_ptr) {
+        return;
+    }
+
+    HashSet *hs = *hs_ptr;
+
+    free(hs->meta);
+    free(hs->keys);
+    free(hs);
+    *hs_ptr = NULL;
+}
+
+size_t hs_size(HashSet *hs) {
+    if(!hs) {
+        fputs("Hash set is NULL.\n", stderr);
+        return 0;
+    }
+
+    return hs->size;
+}
+
+size_t hs_count(HashSet *hs) {
+    if(!hs) {
+        fputs("Hash set is NULL.\n", stderr);
+        return 0;
+    }
+
+    return hs->element_count;
+}
+
+HashSet *hs_init(size_t init_size) {
+    HashSet *hs = malloc(sizeof(HashSet));
+
+    if(!hs) {
+        fputs("Cannot allocate a memory for hash set struct.\n", stderr);
+        return NULL;
+    }
+
+    hs->element_count = 0;
+
+    if(!hs_alloc_slots(hs, init_size == 0 ? 1 : init_size)) {
+        free(hs);
+        return NULL;
+    }
+
+    return hs;
+}
@@ -0,0 +1,30 @@
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HS_EMPTY 0x00
+#define HS_TOMBSTONE 0x01
+
+typedef struct HashSet {
+    size_t size;
+    size_t element_count;
+    size_t tombstone_count;
+    uint8_t *meta;     // HS_EMPTY, HS_TOMBSTONE or 0x80 | 7 bits of the key's hash
+    const char **keys;
+} HashSet;
+
+bool hs_add(HashSet *hs, const char *key);
+bool hs_contains(HashSet *hs, const char *key);
+void hs_remove(HashSet *hs, const char *key);
+HashSet *hs_union(HashSet *a, HashSet *b);
+HashSet *hs_intersect(HashSet *a, HashSet *b);
+HashSet *hs_difference(HashSet *a, HashSet *b);
+void hs_free(HashSet **hs_ptr);
+size_t hs_size(HashSet *hs);
+size_t hs_count(HashSet *hs);
+HashSet *hs_init(size_t init_size);
+
+#endif
@@ -0,0 +1,310 @@
+/*
+    Thread-Safe Sharded Hash Table
+    
+    Description:
+    A concurrent front-end that routes every key to one of N independent hash tables
+    (shards) by the high bits of its FNV-1a hash. Each shard has its own mutex and
+    resizes on its own, so threads working on different shards never wait for each
+    other and a resize only stalls the keys of one shard. Shard headers are aligned
+    to cache lines to prevent false sharing between neighbouring locks.
+
+    Tables created with `ht_sharded_init_optimistic` also give every shard a sequence
+    counter and read without locking. A writer makes the counter odd while it mutates
+    the shard (including resizes) and even again afterwards. A reader samples the
+    counter, probes the shard without the lock and accepts the result only if the
+    counter is still the same even value. Otherwise it retries, and after
+    HT_OPTIMISTIC_RETRIES failed attempts it takes the lock. Removed slots and
+    replaced slot arrays go through epoch-based reclamation, so an optimistic reader
+    never touches freed memory even when its attempt ends up being discarded. Writers
+    retire into their own thread's epoch record, so deletes and resizes in different
+    shards share no lock. A writer that resized a shard reclaims right away, so that
+    the old array is freed even if that thread writes nothing more.
+    Read-mostly tables therefore scale reads with the number of cores.
+
+    The functions mirror `ht_set`, `ht_get`, `ht_try_get`, `ht_delete` and `ht_has`
+    and may be called from any number of threads. As with the hash table, values are
+    owned by the caller: a pointer returned by `ht_sharded_get` stays valid only as
+    long as the caller keeps the value alive.
+
+    Functions:
+    - Initialization (`ht_sharded_init`, or `ht_sharded_init_optimistic` for lock-free
+      reads): the shard count is rounded up to a power of two, and `init_size` is the
+      initial number of slots of every shard. Counts above HT_SHARDED_MAX_SHARDS (2^16)
+      are rejected.
+    - Insertion, retrieval, deletion and existence check (`ht_sharded_set`,
+      `ht_sharded_get`, `ht_sharded_try_get`, `ht_sharded_delete`, `ht_sharded_has`).
+    - Number of elements across all shards (`ht_sharded_count`).
+    - Memory management (`ht_sharded_free`).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashsharded.h"
+#include "hashtable_internal.h"
+
+// Routes by the high hash bits; the shards themselves index by the hash modulo their size
+static HashShard *shard_for(ShardedHashTable *sht, const char *key) {
+    if(sht->shard_bits == 0) {
+        return &sht->shards[0];
+    }
+
+    return &sht->shards[ht_fnv1a(key) >> (32 - sht->shard_bits)];
+}
+
+#define HT_OPTIMISTIC_RETRIES 8
+
+// Queued on the calling thread's epoch record, without a lock
+static void retire_free(void *ptr) {
+    ht_epoch_retire(ptr, free);
+}
+
+static void shard_lock(ShardedHashTable *sht, HashShard *shard) {
+    pthread_mutex_lock(&shard->lock);
+
+    if(sht->optimistic) {
+        atomic_store_explicit(&shard->seq, atomic_load_explicit(&shard->seq, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+}
+
+static void shard_unlock(ShardedHashTable *sht, HashShard *shard) {
+    if(sht->optimistic) {
+        atomic_store_explicit(&shard->seq, atomic_load_explicit(&shard->seq, memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// One lock-free lookup attempt; returns false if a writer interfered and the result must be discarded
+static bool optimistic_lookup(HashShard *shard, const char *key, bool *found, void **out) {
+    unsigned seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+
+    if(seq & 1) {
+        return false;
+    }
+
+    // The size and the array change together, so validate the pair before probing with it
+    HashSlot **table = __atomic_load_n(&shard->ht->table, __ATOMIC_ACQUIRE);
+    size_t size = __atomic_load_n(&shard->ht->size, __ATOMIC_RELAXED);
+
+    atomic_thread_fence(memory_order_acquire);
+
+    if(atomic_load_explicit(&shard->seq, memory_order_relaxed) != seq) {
+        return false;
+    }
+
+    size_t index = ht_fnv1a(key) % size;
+    void *value = NULL;
+    bool hit = false;
+
+    // Bounded, since a concurrent writer may have filled the gaps this probe relies on
+    for(size_t probes = 0; probes < size; probes++) {
+        HashSlot *slot = __atomic_load_n(&table[index], __ATOMIC_ACQUIRE);
+
+        if(!slot) {
+            break;
+        }
+
+        if(slot != TOMBSTONE && strcmp(slot->key, key) == 0) {
+            value = __atomic_load_n(&slot->value, __ATOMIC_RELAXED);
+            hit = true;
+            break;
+        }
+
+        index = (index + 1) % size;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+
+    if(atomic_load_explicit(&shard->seq, memory_order_relaxed) != seq) {
+        return false;
+    }
+
+    *found = hit;
+
+    if(hit && out) {
+        *out = value;
+    }
+
+    return true;
+}
+
+static bool valid_key(ShardedHashTable *sht, const char *key) {
+    return sht && key && *key != '\0';
+}
+
+bool ht_sharded_set(ShardedHashTable *sht, const char *key, void *value) {
+    if(!sht) {
+        fputs("Cannot set a value for an unallocated sharded hash table.\n", stderr);
+        return false;
+    }
+    else if(!key || *key == '\0') {
+        fputs("Key cannot be NULL or an empty string.\n", stderr);
+        return false;
+    }
+
+    HashShard *shard = shard_for(sht, key);
+
+    shard_lock(sht, shard);
+
+    HashSlot **table = shard->ht->table;
+    bool result = ht_set(shard->ht, key, value);
+    bool resized = shard->ht->table != table;
+
+    shard_unlock(sht, shard);
+
+    // The replaced array is the largest thing retired; free it once readers are done
+    if(sht->optimistic && resized) {
+        ht_epoch_reclaim();
+    }
+
+    return result;
+}
+
+const void *ht_sharded_get(ShardedHashTable *sht, const char *key) {
+    void *value = NULL;
+
+    ht_sharded_try_get(sht, key, &value);
+
+    return value;
+}
+
+bool ht_sharded_try_get(ShardedHashTable *sht, const char *key, void **out) {
+    if(!valid_key(sht, key)) {
+        return false;
+    }
+
+    HashShard *shard = shard_for(sht, key);
+    bool found = false;
+
+    if(sht->optimistic) {
+        ht_epoch_enter();
+
+        for(int attempt = 0; attempt < HT_OPTIMISTIC_RETRIES; attempt++) {
+            if(optimistic_lookup(shard, key, &found, out)) {
+                ht_epoch_exit();
+                return found;
+            }
+        }
+
+        ht_epoch_exit();
+    }
+
+    pthread_mutex_lock(&shard->lock);
+    found = ht_try_get(shard->ht, key, out);
+    pthread_mutex_unlock(&shard->lock);
+
+    return found;
+}
+
+void ht_sharded_delete(ShardedHashTable *sht, const char *key) {
+    if(!valid_key(sht, key)) {
+        return;
+    }
+
+    HashShard *shard = shard_for(sht, key);
+
+    shard_lock(sht, shard);
+    ht_delete(shard->ht, key);
+    shard_unlock(sht, shard);
+}
+
+bool ht_sharded_has(ShardedHashTable *sht, const char *key) {
+    return ht_sharded_try_get(sht, key, NULL);
+}
+
+void ht_sharded_free(ShardedHashTable **sht_ptr) {
+    if(!sht_ptr || !*sht_ptr) {
+        return;
+    }
+
+    ShardedHashTable *sht = *sht_ptr;
+
+    for(size_t i = 0; i < sht->shard_count; i++) {
+        pthread_mutex_destroy(&sht->shards[i].lock);
+        ht_free(&sht->shards[i].ht);
+    }
+
+    free(sht->shards);
+    free(sht);
+    *sht_ptr = NULL;
+}
+
+size_t ht_sharded_count(ShardedHashTable *sht) {
+    if(!sht) {
+        fputs("Sharded hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    size_t count = 0;
+
+    for(size_t i = 0; i < sht->shard_count; i++) {
+        pthread_mutex_lock(&sht->shards[i].lock);
+        count += sht->shards[i].ht->element_count;
+        pthread_mutex_unlock(&sht->shards[i].lock);
+    }
+
+    return count;
+}
+
+static ShardedHashTable *sharded_create(size_t shard_count, size_t init_size, bool optimistic) {
+    unsigned shard_bits = 0;
+
+    if(shard_count > HT_SHARDED_MAX_SHARDS) {
+        fprintf(stderr, "Cannot create %zu shards: at most %zu are supported.\n", shard_count, HT_SHARDED_MAX_SHARDS);
+        return NULL;
+    }
+
+    while(((size_t)1 << shard_bits) < shard_count) {
+        shard_bits++;
+    }
+
+    ShardedHashTable *sht = malloc(sizeof(ShardedHashTable));
+
+    if(!sht) {
+        fputs("Cannot allocate a memory for sharded hash table struct.\n", stderr);
+        return NULL;
+    }
+
+    sht->shard_bits = shard_bits;
+    sht->optimistic = optimistic;
+    sht->shard_count = (size_t)1 << shard_bits;
+    sht->shards = aligned_alloc(HT_CACHE_LINE, sht->shard_count * sizeof(HashShard));
+
+    if(!sht->shards) {
+        free(sht);
+        fputs("Cannot allocate a memory for hash table shards.\n", stderr);
+
+        return NULL;
+    }
+
+    for(size_t i = 0; i < sht->shard_count; i++) {
+        sht->shards[i].ht = ht_init(init_size);
+
+        if(!sht->shards[i].ht) {
+            sht->shard_count = i;
+            ht_sharded_free(&sht);
+
+            return NULL;
+        }
+
+        if(optimistic) {
+            sht->shards[i].ht->release = retire_free;
+        }
+
+        atomic_init(&sht->shards[i].seq, 0);
+        pthread_mutex_init(&sht->shards[i].lock, NULL);
+    }
+
+    return sht;
+}
+
+ShardedHashTable *ht_sharded_init(size_t shard_count, size_t init_size) {
+    return sharded_create(shard_count, init_size, false);
+}
+
+ShardedHashTable *ht_sharded_init_optimistic(size_t shard_count, size_t init_size) {
+    return sharded_create(shard_count, init_size, true);
+}
@@ -0,0 +1,41 @@
+#ifndef HASH_SHARDED_H
+#define HASH_SHARDED_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hashtable.h"
+
+#define HT_CACHE_LINE 64
+
+// Each shard starts on its own cache line so that shards never share one
+typedef struct {
+    _Alignas(HT_CACHE_LINE) pthread_mutex_t lock;
+    _Atomic unsigned seq; // odd while a writer mutates the shard (optimistic mode only)
+    HashTable *ht;
+} HashShard;
+
+// The shard index comes from the top bits of a 32-bit hash; more shards are rejected
+#define HT_SHARDED_MAX_SHARDS ((size_t)1 << 16)
+
+typedef struct ShardedHashTable {
+    size_t shard_count; // always a power of two, at most HT_SHARDED_MAX_SHARDS
+    unsigned shard_bits;
+    bool optimistic;    // lock-free seqlock-validated reads
+    HashShard *shards;
+} ShardedHashTable;
+
+bool ht_sharded_set(ShardedHashTable *sht, const char *key, void *value);
+const void *ht_sharded_get(ShardedHashTable *sht, const char *key);
+bool ht_sharded_try_get(ShardedHashTable *sht, const char *key, void **out);
+void ht_sharded_delete(ShardedHashTable *sht, const char *key);
+bool ht_sharded_has(ShardedHashTable *sht, const char *key);
+void ht_sharded_free(ShardedHashTable **sht_ptr);
+size_t ht_sharded_count(ShardedHashTable *sht);
+ShardedHashTable *ht_sharded_init(size_t shard_count, size_t init_size);
+ShardedHashTable *ht_sharded_init_optimistic(size_t shard_count, size_t init_size);
+
+#endif
@@ -0,0 +1,560 @@
+/*
+    Binary Table Snapshots
+    
+    Description:
+    Saves a hash table to a file and loads it back without re-inserting anything. The
+    file stores the slot array as it is, one record per entry (with the key's hash
+    and expiry) and a blob holding the keys and values. Slots keep their indices, so
+    loading is one sequential read followed by pointer fix-ups: no key is hashed and
+    no slot is probed. The layout is described in `hashtable_internal.h`.
+
+    A checksum over the whole file, kept in a trailer, detects truncated or corrupted
+    files before anything is built from them. Files are versioned and record the byte
+    order they were written in; a file written by an unknown version or on a machine
+    of the other byte order is rejected.
+
+    Values are opaque pointers, so the caller says how many bytes each one spans
+    (`ht_save_values`); `ht_save` treats them as NUL-terminated strings. NULL values
+    are stored as such. A loaded table owns its keys and values: they live in one
+    block that `ht_free` releases. Entries added to it afterwards follow the usual
+    rules and are owned by the caller.
+
+    The file is written to a temporary name, synced, and then renamed over the target,
+    so a crash during a save never leaves a half-written file in its place. Writing
+    goes through a fixed-size buffer and never holds more than one chunk of the file
+    in memory.
+
+    A snapshot can also be written in the background while the table keeps serving
+    writes (`ht_snapshot_start`). The process forks, and the child streams the table
+    as it was at the moment of the fork to a file descriptor, in the same format and
+    through the same fixed-size buffer, then exits. Copy-on-write keeps the child's
+    view frozen: writes in the parent after the fork are not part of the snapshot,
+    and each one costs at most a page copy the first time it touches a page. The
+    stream never seeks, so the descriptor can be a file, a pipe or a socket. The
+    child allocates no memory and touches no locks, so forking a multi-threaded
+    process is safe; the value size callback must follow the same rules.
+
+    Functions:
+    - Saving (`ht_save`, `ht_save_values`).
+    - Loading (`ht_load`).
+    - Background snapshots (`ht_snapshot_start`, `ht_snapshot_poll`, `ht_snapshot_wait`).
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "hashsnapshot.h"
+#include "hashtable_internal.h"
+
+#define HT_FILE_BUFFER (64 * 1024)
+
+typedef struct {
+    int fd;
+    size_t used;
+    uint64_t checksum;
+    bool failed;
+    unsigned char buffer[HT_FILE_BUFFER];
+} HashFileWriter;
+
+static size_t align_up(size_t offset) {
+    return (offset + HT_FILE_ALIGN - 1) / HT_FILE_ALIGN * HT_FILE_ALIGN;
+}
+
+static size_t string_size(const void *value) {
+    return strlen(value) + 1;
+}
+
+static bool write_all(int fd, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+
+    while(length > 0) {
+        ssize_t written = write(fd, bytes, length);
+
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        else if(written <= 0) {
+            return false;
+        }
+
+        bytes += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+// Only a full buffer or the end of the checksummed data is flushed, which keeps every
+// piece the checksum sees but the last one a multiple of 8 bytes
+static void writer_flush(HashFileWriter *writer) {
+    writer->checksum = ht_file_checksum(writer->checksum, writer->buffer, writer->used);
+
+    if(!writer->failed && !write_all(writer->fd, writer->buffer, writer->used)) {
+        writer->failed = true;
+    }
+
+    writer->used = 0;
+}
+
+static void writer_put(HashFileWriter *writer, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+
+    while(length > 0) {
+        size_t chunk = HT_FILE_BUFFER - writer->used < length ? HT_FILE_BUFFER - writer->used : length;
+
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        length -= chunk;
+
+        if(writer->used == HT_FILE_BUFFER) {
+            writer_flush(writer);
+        }
+    }
+}
+
+static void writer_pad(HashFileWriter *writer, size_t length) {
+    static const unsigned char zeros[HT_FILE_ALIGN];
+
+    while(length > 0) {
+        size_t chunk = length < HT_FILE_ALIGN ? length : HT_FILE_ALIGN;
+
+        writer_put(writer, zeros, chunk);
+        length -= chunk;
+    }
+}
+
+static bool is_entry(HashSlot *slot) {
+    return slot && slot != TOMBSTONE;
+}
+
+// Advances a blob offset past one entry's key and value
+static size_t blob_advance(size_t offset, HashSlot *slot, HashValueSize value_size, HashFileEntry *entry) {
+    entry->key_offset = offset;
+    entry->key_length = (uint32_t)strlen(slot->key);
+    offset += entry->key_length + 1;
+
+    if(slot->value) {
+        offset = align_up(offset);
+        entry->value_offset = offset;
+        entry->value_length = value_size(slot->value);
+        offset += entry->value_length;
+    }
+    else {
+        entry->value_offset = HT_FILE_NULL_VALUE;
+        entry->value_length = 0;
+    }
+
+    return offset;
+}
+
+// Streams the table to fd in the file format. Uses no heap memory, so that it can run
+// in a forked child of a multi-threaded process.
+static bool write_table(HashTable *ht, int fd, HashValueSize value_size, HashFileWriter *writer) {
+    HashFileHeader header = {HT_FILE_MAGIC, HT_FILE_VERSION, HT_FILE_BYTE_ORDER, ht->size};
+    HashFileEntry entry = {0};
+    size_t blob_size = 0;
+
+    // First pass: entry count and blob size, so that every section's offset is known up front
+    for(size_t i = 0; i < ht->size; i++) {
+        if(is_entry(ht->table[i])) {
+            blob_size = blob_advance(blob_size, ht->table[i], value_size, &entry);
+            header.count++;
+        }
+    }
+
+    header.slots_offset = sizeof(HashFileHeader);
+    header.entries_offset = header.slots_offset + header.size * sizeof(uint64_t);
+    header.blob_offset = align_up(header.entries_offset + header.count * sizeof(HashFileEntry));
+    header.blob_size = align_up(blob_size); // keeps the trailer aligned
+
+    writer->fd = fd;
+    writer->used = 0;
+    writer->checksum = HT_FILE_CHECKSUM_SEED;
+    writer->failed = false;
+    writer_put(writer, &header, sizeof(header));
+
+    uint64_t next_entry = 1;
+
+    for(size_t i = 0; i < ht->size; i++) {
+        HashSlot *slot = ht->table[i];
+        uint64_t ref = !slot ? 0 : slot == TOMBSTONE ? HT_FILE_TOMBSTONE : next_entry++;
+
+        writer_put(writer, &ref, sizeof(ref));
+    }
+
+    blob_size = 0;
+
+    for(size_t i = 0; i < ht->size; i++) {
+        HashSlot *slot = ht->table[i];
+
+        if(!is_entry(slot)) {
+            continue;
+        }
+
+        blob_size = blob_advance(blob_size, slot, value_size, &entry);
+        entry.hash = ht_fnv1a(slot->key);
+        entry.flags = slot->timer ? HT_FILE_ENTRY_TTL : 0;
+        entry.expires_at = slot->timer ? slot->timer->expires_at : 0;
+        writer_put(writer, &entry, sizeof(entry));
+    }
+
+    writer_pad(writer, header.blob_offset - (header.entries_offset + header.count * sizeof(HashFileEntry)));
+    blob_size = 0;
+
+    for(size_t i = 0; i < ht->size; i++) {
+        HashSlot *slot = ht->table[i];
+
+        if(!is_entry(slot)) {
+            continue;
+        }
+
+        size_t end = blob_advance(blob_size, slot, value_size, &entry);
+
+        writer_put(writer, slot->key, entry.key_length + 1);
+
+        if(slot->value) {
+            writer_pad(writer, entry.value_offset - (entry.key_offset + entry.key_length + 1));
+            writer_put(writer, slot->value, entry.value_length);
+        }
+
+        blob_size = end;
+    }
+
+    writer_pad(writer, header.blob_size - blob_size);
+    writer_flush(writer);
+
+    HashFileTrailer trailer = {writer->checksum, HT_FILE_TRAILER_MAGIC};
+
+    return !writer->failed && write_all(fd, &trailer, sizeof(trailer));
+}
+
+bool ht_save_values(HashTable *ht, const char *path, HashValueSize value_size) {
+    if(!ht || !ht->table) {
+        fputs("Cannot save an unallocated hash table.\n", stderr);
+        return false;
+    }
+    else if(!path) {
+        fputs("Snapshot path cannot be NULL.\n", stderr);
+        return false;
+    }
+
+    size_t path_length = strlen(path);
+    char *temp_path = malloc(path_length + sizeof(".tmp"));
+    HashFileWriter *writer = malloc(sizeof(HashFileWriter));
+
+    if(!temp_path || !writer) {
+        free(temp_path);
+        free(writer);
+        fputs("Cannot allocate a memory for hash table snapshot.\n", stderr);
+
+        return false;
+    }
+
+    memcpy(temp_path, path, path_length);
+    memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0
+        && write_table(ht, fd, value_size ? value_size : string_size, writer)
+        && fsync(fd) == 0;
+
+    if(fd >= 0 && close(fd) != 0) {
+        ok = false;
+    }
+
+    if(ok && rename(temp_path, path) != 0) {
+        ok = false;
+    }
+
+    if(!ok) {
+        fprintf(stderr, "Cannot save hash table to '%s': %s.\n", path, strerror(errno));
+        unlink(temp_path);
+    }
+
+    free(temp_path);
+    free(writer);
+
+    return ok;
+}
+
+bool ht_save(HashTable *ht, const char *path) {
+    return ht_save_values(ht, path, NULL);
+}
+
+const HashFileHeader *ht_file_validate(const void *data, size_t length, bool checksum) {
+    const HashFileHeader *header = data;
+
+    if(length < sizeof(HashFileHeader) + sizeof(HashFileTrailer) || memcmp(header->magic, HT_FILE_MAGIC, 8) != 0) {
+        fputs("Not a hash table file.\n", stderr);
+        return NULL;
+    }
+    else if(header->byte_order != HT_FILE_BYTE_ORDER) {
+        fputs("Hash table file was written on a machine of a different byte order.\n", stderr);
+        return NULL;
+    }
+    else if(header->version != HT_FILE_VERSION) {
+        fprintf(stderr, "Unsupported hash table file version %u.\n", header->version);
+        return NULL;
+    }
+
+    uint64_t body = length - sizeof(HashFileTrailer);
+    const HashFileTrailer *trailer = (const HashFileTrailer *)((const char *)data + body);
+
+    if(header->size == 0
+        || header->count > header->size
+        || header->size > UINT64_MAX / sizeof(HashFileEntry)
+        || header->slots_offset != sizeof(HashFileHeader)
+        || !ht_file_in_bounds(header->slots_offset, header->size * sizeof(uint64_t), body)
+        || header->entries_offset % 8 != 0
+        || !ht_file_in_bounds(header->entries_offset, header->count * sizeof(HashFileEntry), body)
+        || header->blob_offset % HT_FILE_ALIGN != 0
+        || !ht_file_in_bounds(header->blob_offset, header->blob_size, body)
+        || header->blob_offset + header->blob_size != body
+        || header->blob_offset < header->entries_offset + header->count * sizeof(HashFileEntry)
+        || memcmp(trailer->magic, HT_FILE_TRAILER_MAGIC, 8) != 0) {
+        fputs("Hash table file is truncated or corrupted.\n", stderr);
+        return NULL;
+    }
+
+    if(checksum && ht_file_checksum(HT_FILE_CHECKSUM_SEED, data, body) != trailer->checksum) {
+        fputs("Hash table file checksum mismatch.\n", stderr);
+        return NULL;
+    }
+
+    return header;
+}
+
+static bool read_file(const char *path, unsigned char **data, size_t *length) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Cannot open hash table file '%s': %s.\n", path, strerror(errno));
+
+        if(fd >= 0) {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    *length = st.st_size;
+    *data = malloc(*length ? *length : 1);
+
+    size_t done = 0;
+
+    while(*data && done < *length) {
+        ssize_t n = read(fd, *data + done, *length - done);
+
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        else if(n <= 0) {
+            break;
+        }
+
+        done += n;
+    }
+
+    close(fd);
+
+    if(!*data || done < *length) {
+        fprintf(stderr, "Cannot read hash table file '%s'.\n", path);
+        free(*data);
+
+        return false;
+    }
+
+    return true;
+}
+
+// Points the table's slots at the entries of a validated file image it now owns
+static bool attach_entries(HashTable *ht, const HashFileHeader *header, unsigned char *data) {
+    const uint64_t *refs = (const uint64_t *)(data + header->slots_offset);
+    const HashFileEntry *entries = (const HashFileEntry *)(data + header->entries_offset);
+    char *blob = (char *)data + header->blob_offset;
+
+    for(uint64_t i = 0; i < header->count; i++) {
+        const HashFileEntry *entry = &entries[i];
+        HashSlot *slot = &ht->slab[i];
+
+        if(!ht_file_in_bounds(entry->key_offset, (uint64_t)entry->key_length + 1, header->blob_size)
+            || entry->key_length == 0
+            || blob[entry->key_offset + entry->key_length] != '\0'
+            || (entry->value_offset != HT_FILE_NULL_VALUE && !ht_file_in_bounds(entry->value_offset, entry->value_length, header->blob_size))) {
+            return false;
+        }
+
+        slot->key = blob + entry->key_offset;
+        slot->value = entry->value_offset != HT_FILE_NULL_VALUE ? blob + entry->value_offset : NULL;
+        slot->timer = NULL;
+
+        if(entry->flags & HT_FILE_ENTRY_TTL) {
+            if(!ht->wheel && !(ht->wheel = ht_wheel_create())) {
+                return false;
+            }
+
+            if(!(slot->timer = malloc(sizeof(HashTimer)))) {
+                return false;
+            }
+
+            slot->timer->data = slot;
+            slot->timer->expires_at = entry->expires_at;
+            ht_wheel_schedule(ht->wheel, slot->timer);
+        }
+    }
+
+    uint64_t seen = 0;
+
+    for(uint64_t i = 0; i < header->size; i++) {
+        if(refs[i] == 0) {
+            continue;
+        }
+        else if(refs[i] == HT_FILE_TOMBSTONE) {
+            ht->table[i] = TOMBSTONE;
+        }
+        else if(refs[i] <= header->count) {
+            ht->table[i] = &ht->slab[refs[i] - 1];
+            seen++;
+        }
+        else {
+            return false;
+        }
+    }
+
+    ht->element_count = seen;
+
+    return seen == header->count;
+}
+
+HashTable *ht_load(const char *path) {
+    if(!path) {
+        fputs("Snapshot path cannot be NULL.\n", stderr);
+        return NULL;
+    }
+
+    unsigned char *data;
+    size_t length;
+
+    if(!read_file(path, &data, &length)) {
+        return NULL;
+    }
+
+    const HashFileHeader *header = ht_file_validate(data, length, true);
+    HashTable *ht = header && header->size <= SIZE_MAX / sizeof(HashSlot *) ? ht_init(header->size) : NULL;
+
+    if(!ht || !ht_own_memory(ht, data)) {
+        free(data);
+        ht_free(&ht);
+
+        return NULL;
+    }
+
+    ht->slab = calloc(header->count ? header->count : 1, sizeof(HashSlot));
+    ht->slab_count = header->count;
+
+    if(!ht->slab || !attach_entries(ht, header, data)) {
+        fprintf(stderr, "Cannot load hash table from '%s': invalid entries or out of memory.\n", path);
+
+        // The slots are only partly set up; drop them before freeing the table
+        for(size_t i = 0; i < ht->size; i++) {
+            ht->table[i] = NULL;
+        }
+
+        for(size_t i = 0; ht->slab && i < ht->slab_count; i++) {
+            free(ht->slab[i].timer);
+        }
+
+        free(ht->wheel);
+        ht->wheel = NULL;
+        ht_free(&ht);
+    }
+
+    return ht;
+}
+
+bool ht_snapshot_start(HashTable *ht, int fd, HashValueSize value_size, HashSnapshot *snapshot) {
+    if(!ht || !ht->table || !snapshot) {
+        fputs("Cannot snapshot an unallocated hash table.\n", stderr);
+        return false;
+    }
+
+    // Allocated before the fork; the child gets its own copy and the parent drops its one
+    HashFileWriter *writer = malloc(sizeof(HashFileWriter));
+
+    if(!writer) {
+        fputs("Cannot allocate a memory for hash table snapshot.\n", stderr);
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if(pid == 0) {
+        bool ok = write_table(ht, fd, value_size ? value_size : string_size, writer);
+
+        // Pipes and sockets cannot be synced; that is not an error
+        if(ok && fsync(fd) != 0 && errno != EINVAL && errno != EROFS) {
+            ok = false;
+        }
+
+        _exit(ok ? 0 : 1);
+    }
+
+    free(writer);
+
+    if(pid < 0) {
+        fprintf(stderr, "Cannot start hash table snapshot: %s.\n", strerror(errno));
+        return false;
+    }
+
+    snapshot->pid = pid;
+    snapshot->finished = false;
+    snapshot->ok = false;
+
+    return true;
+}
+
+static void snapshot_reap(HashSnapshot *snapshot, int options) {
+    int status;
+    pid_t pid;
+
+    do {
+        pid = waitpid(snapshot->pid, &status, options);
+    } while(pid < 0 && errno == EINTR);
+
+    if(pid == snapshot->pid) {
+        snapshot->finished = true;
+        snapshot->ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    else if(pid < 0) {
+        snapshot->finished = true;
+        snapshot->ok = false;
+    }
+}
+
+bool ht_snapshot_poll(HashSnapshot *snapshot) {
+    if(snapshot && !snapshot->finished) {
+        snapshot_reap(snapshot, WNOHANG);
+    }
+
+    return !snapshot || snapshot->finished;
+}
+
+bool ht_snapshot_wait(HashSnapshot *snapshot) {
+    if(!snapshot) {
+        return false;
+    }
+
+    if(!snapshot->finished) {
+        snapshot_reap(snapshot, 0);
+    }
+
+    return snapshot->ok;
+}
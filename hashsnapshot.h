@@ -0,0 +1,29 @@
+#ifndef HASH_SNAPSHOT_H
+#define HASH_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "hashtable.h"
+
+// Number of bytes to save for a value; values are copied as plain bytes
+typedef size_t (*HashValueSize)(const void *value);
+
+// A snapshot being written in the background by a forked child
+typedef struct {
+    pid_t pid;
+    bool finished;
+    bool ok;
+} HashSnapshot;
+
+bool ht_save(HashTable *ht, const char *path);
+bool ht_save_values(HashTable *ht, const char *path, HashValueSize value_size);
+HashTable *ht_load(const char *path);
+// Call with the table's write lock held: the fork copies memory as it is at that instant,
+// so a write in progress on another thread would leave the child a half-updated slot array
+bool ht_snapshot_start(HashTable *ht, int fd, HashValueSize value_size, HashSnapshot *snapshot);
+bool ht_snapshot_poll(HashSnapshot *snapshot);
+bool ht_snapshot_wait(HashSnapshot *snapshot);
+
+#endif
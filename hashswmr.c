@@ -0,0 +1,296 @@
+/*
+    Single-Writer Hash Table with Lock-Free Reads
+    
+    Description:
+    A hash table for one writer thread and any number of reader threads in which
+    readers take no lock and never write memory shared with other threads.
+
+    - Slots hold atomic pointers to immutable-key entries. The writer fills an entry
+      completely before publishing it with a release store, and readers load slots with
+      acquire, so a reader that sees an entry also sees its key and value.
+    - Updating an existing key is a single atomic store to the entry's value.
+    - Deleting a key replaces its slot with a tombstone. The entry itself is retired
+      through epoch-based reclamation, since a reader may still be comparing its key.
+    - A resize builds the new slot array off to the side and publishes it by swapping
+      a single atomic pointer. The slot count travels with the array, so readers always
+      see a matching size and array. The old array is retired the same way.
+
+    Readers may call `ht_swmr_get`, `ht_swmr_try_get`, `ht_swmr_has` and
+    `ht_swmr_count` from any thread. `ht_swmr_set` and `ht_swmr_delete` must only be
+    called from one thread at a time. `ht_swmr_free` requires that no other thread
+    is still using the table.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashswmr.h"
+#include "hashtable.h"
+#include "hashtable_internal.h"
+
+static HashSwmrArray *swmr_alloc_array(size_t size) {
+    HashSwmrArray *array = calloc(1, sizeof(HashSwmrArray) + size * sizeof(HashSwmrEntry *));
+
+    if(!array) {
+        fputs("Cannot allocate a memory for hash table slots.\n", stderr);
+        return NULL;
+    }
+
+    array->size = size;
+
+    return array;
+}
+
+// Reader-side probe; must run inside an epoch section
+static HashSwmrEntry *swmr_lookup(SwmrHashTable *st, const char *key) {
+    HashSwmrArray *array = atomic_load_explicit(&st->array, memory_order_acquire);
+    size_t index = ht_fnv1a(key) % array->size;
+    HashSwmrEntry *entry;
+
+    while((entry = atomic_load_explicit(&array->slots[index], memory_order_acquire))) {
+        if(entry != SWMR_TOMBSTONE && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+
+        index = (index + 1) % array->size;
+    }
+
+    return NULL;
+}
+
+// Writer-side probe; returns the slot index of key or SIZE_MAX
+static size_t swmr_find(HashSwmrArray *array, const char *key) {
+    size_t index = ht_fnv1a(key) % array->size;
+    HashSwmrEntry *entry;
+
+    while((entry = atomic_load_explicit(&array->slots[index], memory_order_relaxed))) {
+        if(entry != SWMR_TOMBSTONE && strcmp(entry->key, key) == 0) {
+            return index;
+        }
+
+        index = (index + 1) % array->size;
+    }
+
+    return SIZE_MAX;
+}
+
+// Publishes a rehashed copy of the slot array and retires the old one
+static bool swmr_rehash(SwmrHashTable *st, size_t new_size) {
+    HashSwmrArray *old_array = atomic_load_explicit(&st->array, memory_order_relaxed);
+    HashSwmrArray *new_array = swmr_alloc_array(new_size);
+
+    if(!new_array) {
+        return false;
+    }
+
+    for(size_t i = 0; i < old_array->size; i++) {
+        HashSwmrEntry *entry = atomic_load_explicit(&old_array->slots[i], memory_order_relaxed);
+
+        if(entry && entry != SWMR_TOMBSTONE) {
+            size_t index = ht_fnv1a(entry->key) % new_size;
+
+            while(atomic_load_explicit(&new_array->slots[index], memory_order_relaxed)) {
+                index = (index + 1) % new_size;
+            }
+
+            atomic_store_explicit(&new_array->slots[index], entry, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&st->array, new_array, memory_order_release);
+    st->tombstone_count = 0;
+    ht_epoch_retire(old_array, free);
+
+    return true;
+}
+
+bool ht_swmr_set(SwmrHashTable *st, const char *key, void *value) {
+    if(!st) {
+        fputs("Cannot set a value for an unallocated hash table.\n", stderr);
+        return false;
+    }
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return false;
+    }
+    else if(*key == '\0') {
+        fputs("Key cannot be an empty string.\n", stderr);
+        return false;
+    }
+
+    HashSwmrArray *array = atomic_load_explicit(&st->array, memory_order_relaxed);
+    size_t count = atomic_load_explicit(&st->element_count, memory_order_relaxed);
+    size_t index = swmr_find(array, key);
+
+    if(index != SIZE_MAX) {
+        HashSwmrEntry *entry = atomic_load_explicit(&array->slots[index], memory_order_relaxed);
+
+        atomic_store_explicit(&entry->value, value, memory_order_release);
+
+        return true;
+    }
+
+    // Tombstones count towards the load so that probe sequences always end at an empty slot
+    if((float)(count + st->tombstone_count + 1) / (float)array->size > LOAD_FACTOR_THRESHOLD) {
+        size_t new_size = array->size;
+
+        if((float)(count + 1) / (float)array->size > LOAD_FACTOR_THRESHOLD / 2) {
+            if(array->size > SIZE_MAX / 2) {
+                fputs("Hash table resize failed: cannot double size beyond maximum limit (SIZE_MAX).\n", stderr);
+                return false;
+            }
+
+            new_size = array->size * 2;
+        }
+
+        if(!swmr_rehash(st, new_size)) {
+            fprintf(stderr, "Hash table resize failed, cannot insert key '%s'.\n", key);
+            return false;
+        }
+
+        array = atomic_load_explicit(&st->array, memory_order_relaxed);
+    }
+
+    HashSwmrEntry *entry = malloc(sizeof(HashSwmrEntry));
+
+    if(!entry) {
+        fputs("Cannot allocate a memory for hash table entry.\n", stderr);
+        return false;
+    }
+
+    entry->key = key;
+    atomic_init(&entry->value, value);
+
+    index = ht_fnv1a(key) % array->size;
+
+    HashSwmrEntry *current;
+
+    while((current = atomic_load_explicit(&array->slots[index], memory_order_relaxed)) && current != SWMR_TOMBSTONE) {
+        index = (index + 1) % array->size;
+    }
+
+    if(current == SWMR_TOMBSTONE) {
+        st->tombstone_count--;
+    }
+
+    atomic_store_explicit(&array->slots[index], entry, memory_order_release);
+    atomic_store_explicit(&st->element_count, count + 1, memory_order_relaxed);
+
+    return true;
+}
+
+const void *ht_swmr_get(SwmrHashTable *st, const char *key) {
+    void *value = NULL;
+
+    ht_swmr_try_get(st, key, &value);
+
+    return value;
+}
+
+bool ht_swmr_try_get(SwmrHashTable *st, const char *key, void **out) {
+    if(!st || !key || *key == '\0') {
+        return false;
+    }
+
+    ht_epoch_enter();
+
+    HashSwmrEntry *entry = swmr_lookup(st, key);
+
+    if(entry && out) {
+        *out = atomic_load_explicit(&entry->value, memory_order_acquire);
+    }
+
+    ht_epoch_exit();
+
+    return entry != NULL;
+}
+
+void ht_swmr_delete(SwmrHashTable *st, const char *key) {
+    if(!st || !key || *key == '\0') {
+        return;
+    }
+
+    HashSwmrArray *array = atomic_load_explicit(&st->array, memory_order_relaxed);
+    size_t index = swmr_find(array, key);
+
+    if(index == SIZE_MAX) {
+        return;
+    }
+
+    HashSwmrEntry *entry = atomic_load_explicit(&array->slots[index], memory_order_relaxed);
+
+    atomic_store_explicit(&array->slots[index], SWMR_TOMBSTONE, memory_order_release);
+    atomic_fetch_sub_explicit(&st->element_count, 1, memory_order_relaxed);
+    st->tombstone_count++;
+    ht_epoch_retire(entry, free);
+}
+
+bool ht_swmr_has(SwmrHashTable *st, const char *key) {
+    return ht_swmr_try_get(st, key, NULL);
+}
+
+void ht_swmr_free(SwmrHashTable **st_ptr) {
+    if(!st_ptr || !*st_ptr) {
+        return;
+    }
+
+    SwmrHashTable *st = *st_ptr;
+    HashSwmrArray *array = atomic_load(&st->array);
+
+    for(size_t i = 0; i < array->size; i++) {
+        HashSwmrEntry *entry = atomic_load_explicit(&array->slots[i], memory_order_relaxed);
+
+        if(entry && entry != SWMR_TOMBSTONE) {
+            free(entry);
+        }
+    }
+
+    free(array);
+    free(st);
+    *st_ptr = NULL;
+}
+
+size_t ht_swmr_size(SwmrHashTable *st) {
+    if(!st) {
+        fputs("Hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    ht_epoch_enter();
+    size_t size = atomic_load_explicit(&st->array, memory_order_acquire)->size;
+    ht_epoch_exit();
+
+    return size;
+}
+
+size_t ht_swmr_count(SwmrHashTable *st) {
+    if(!st) {
+        fputs("Hash table is NULL.\n", stderr);
+        return 0;
+    }
+
+    return atomic_load_explicit(&st->element_count, memory_order_relaxed);
+}
+
+SwmrHashTable *ht_swmr_init(size_t init_size) {
+    SwmrHashTable *st = malloc(sizeof(SwmrHashTable));
+
+    if(!st) {
+        fputs("Cannot allocate a memory for hash table struct.\n", stderr);
+        return NULL;
+    }
+
+    HashSwmrArray *array = swmr_alloc_array(init_size == 0 ? 1 : init_size);
+
+    if(!array) {
+        free(st);
+        return NULL;
+    }
+
+    atomic_init(&st->array, array);
+    atomic_init(&st->element_count, 0);
+    st->tombstone_count = 0;
+
+    return st;
+}
@@ -0,0 +1,37 @@
+#ifndef HASH_SWMR_H
+#define HASH_SWMR_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *key;
+    _Atomic(void *) value;
+} HashSwmrEntry;
+
+#define SWMR_TOMBSTONE ((HashSwmrEntry *)(intptr_t)-1)
+
+typedef struct {
+    size_t size;
+    _Atomic(HashSwmrEntry *) slots[];
+} HashSwmrArray;
+
+typedef struct SwmrHashTable {
+    _Atomic(HashSwmrArray *) array;
+    _Atomic size_t element_count;
+    size_t tombstone_count; // writer only
+} SwmrHashTable;
+
+bool ht_swmr_set(SwmrHashTable *st, const char *key, void *value);
+const void *ht_swmr_get(SwmrHashTable *st, const char *key);
+bool ht_swmr_try_get(SwmrHashTable *st, const char *key, void **out);
+void ht_swmr_delete(SwmrHashTable *st, const char *key);
+bool ht_swmr_has(SwmrHashTable *st, const char *key);
+void ht_swmr_free(SwmrHashTable **st_ptr);
+size_t ht_swmr_size(SwmrHashTable *st);
+size_t ht_swmr_count(SwmrHashTable *st);
+SwmrHashTable *ht_swmr_init(size_t init_size);
+
+#endif
@@ -14,6 +14,12 @@
     - Delete Entries: Remove key-value pairs from the hash table.
     - Check for Key Existence: Verify if a specific key is present.
     - Dynamic Resizing: Automatically resizes when the load factor exceeds a threshold, ensuring efficiency.
+    - Parallel Resizing: Large tables can be rehashed by several threads at once.
+    - NUMA Placement: The slot array can be interleaved over all nodes or bound to one.
+    - Huge Pages: Large slot arrays can be backed by 2 MiB pages to cut TLB misses.
+    - Bulk Building: A table can be built from arrays of keys and values on several threads.
+    - Expiring Entries: Entries can carry an expiry time and are reaped incrementally through a
+      hierarchical timer wheel, with a caller-chosen bound on the work done per tick.
     - Generalized Data Storage: The hash table can store **any data type** as values, 
       provided the user supplies a pointer to the data.
     - Utility Functions: Free memory and get details like size 
@@ -23,8 +29,12 @@
     - Keys must be strings (`const char *`), and they should be immutable and valid for the 
       lifetime of the hash table.
     - Values are stored as generic `void *` pointers, allowing storage of any data type (e.g., integers, 
-      floats, structs, or even other hash tables).
+      floats, structs, or even other hash tables). NULL is a valid value; use `ht_try_get` to
+      distinguish it from a missing key.
     - The user is responsible for managing memory associated with stored values.
+    - The table is not synchronized. Slots are published with release stores and removed
+      memory goes through the optional `release` hook, so that owners such as the sharded
+      table can run validated lock-free readers next to a locked writer.
 
     Functions:
     - Initialization:
@@ -33,10 +43,44 @@
         Add a key-value pair to the hash table. Automatically handles collisions using linear probing.
     - Retrieval (`ht_get`):
         Retrieve the value associated with a given key.
+    - Lookup with presence (`ht_try_get`):
+        Retrieve a value and report whether the key exists in a single probe,
+        so that NULL values can be told apart from missing keys.
     - Deletion (`ht_delete`):
         Remove a key-value pair from the hash table.
     - Existence Check (`ht_has`):
         Check if a specific key exists in the hash table.
+    - Expiry (`ht_set_ttl`, `ht_expire_tick`):
+        Insert a key-value pair that expires at a given time, and reap expired entries.
+        Times are opaque 64-bit values in the caller's unit. Once `ht_expire_tick` has
+        been told the current time, entries that expired at or before it read as absent,
+        even if the tick's budget ran out before they were removed. A plain `ht_set` on
+        an expiring key makes it persistent again.
+    - Parallel Resizing (`ht_set_resize_threads`):
+        Set how many threads rehash the table when it grows. Each worker takes a range
+        of old home buckets and owns the matching destination buckets in the doubled
+        array: an entry whose old home is h lands at h or h + size, so workers write to
+        disjoint ranges without locking. The rare entry whose probe would run past the
+        end of its worker's range is set aside and placed afterwards on the calling
+        thread. Tables too small to be worth splitting are rehashed serially.
+    - Bulk Build (`ht_build`):
+        Build a table from n keys and values in one go. The table is sized once for n
+        entries, keys are hashed in parallel, radix-partitioned by destination bucket
+        range (stably, so later duplicates of a key win, as with repeated `ht_set`), and
+        the partitions are filled concurrently. As in a parallel resize, entries that
+        would probe out of their partition are placed serially at the end. All slots come
+        from one block; deleting a built entry leaves its slot in that block until
+        `ht_free`.
+    - NUMA Placement (`ht_init_numa`):
+        Create a table whose slot array is interleaved over all NUMA nodes or bound to
+        one node. Every array the table grows into gets the same placement. A bound
+        table also takes its slots from an arena on its node, so a lookup reads only
+        local memory up to the key; slots of other tables come from the regular
+        allocator.
+    - Huge Pages (`ht_set_huge_pages`):
+        Back the slot array with huge pages, now and after every resize. Explicit huge
+        pages are used when the system has reserved some, and transparent huge pages
+        otherwise. Arrays smaller than one huge page keep regular pages.
     - Memory Management (`ht_free`):
           Clean up and release all memory used by the hash table.
     - Utility:
@@ -50,25 +94,18 @@
 #include <limits.h>
 
 #include "hashtable.h"
+#include "hashtable_internal.h"
 
 static void mem_alloc_error(const char *err) {
     fprintf(stderr, "Cannot allocate a memory for %s.\n", err);
 }
 
-// FNV-1a (Fowler-Noll-Vo) Algorithm
 static uint32_t hash(const char *key, size_t size) {
-    uint32_t hash_value = 2166136261; // FNV offset basis
-
-    for(size_t i = 0; key[i] != '\0'; i++) {
-        hash_value ^= (unsigned char)key[i];
-        hash_value *= 16777619; // FNV prime
-    }
-
-    return hash_value % size;
+    return ht_fnv1a(key) % size;
 }
 
-static HashSlot *create_hash_slot() {
-    HashSlot *hash_slot = malloc(sizeof(HashSlot));
+static HashSlot *create_hash_slot(HashTable *ht) {
+    HashSlot *hash_slot = ht->arena ? ht_node_arena_alloc(ht->arena, sizeof(HashSlot)) : malloc(sizeof(HashSlot));
 
     if(!hash_slot) {
         return NULL;
@@ -76,20 +113,207 @@ static HashSlot *create_hash_slot() {
 
     hash_slot->key = NULL;
     hash_slot->value = NULL;
+    hash_slot->timer = NULL;
 
     return hash_slot;
 }
 
-static void free_new_table(HashSlot **table, size_t size) {
-    // Free the new hash table
-    for(size_t i = 0; i < size; i++) {
-        if(table[i]) {
-            free(table[i]);
+// Frees a slot or slot array, or hands it to the owner's release hook when readers may still see it
+static void release_memory(HashTable *ht, void *ptr) {
+    if(ht->release) {
+        ht->release(ptr);
+    }
+    else {
+        free(ptr);
+    }
+}
+
+// Allocates a zeroed slot array placed as the table asks and reports how in *memory
+static HashSlot **alloc_table(HashTable *ht, size_t size, unsigned char *memory) {
+    bool huge = ht->huge_pages && size >= HT_HUGE_PAGE_SIZE / sizeof(HashSlot *);
+
+    if(ht->numa_policy == HT_NUMA_DEFAULT && !huge) {
+        *memory = HT_MEMORY_HEAP;
+        return calloc(size, sizeof(HashSlot *));
+    }
+    else if(size > SIZE_MAX / sizeof(HashSlot *)) {
+        return NULL;
+    }
+
+    HashSlot **table = ht_pages_alloc(size * sizeof(HashSlot *), huge);
+
+    if(table && ht->numa_policy != HT_NUMA_DEFAULT) {
+        ht_numa_place(table, size * sizeof(HashSlot *), ht->numa_policy, ht->numa_node);
+    }
+
+    *memory = huge ? HT_MEMORY_HUGE : HT_MEMORY_MAPPED;
+
+    return table;
+}
+
+static void free_table(HashSlot **table, size_t size, unsigned char memory) {
+    if(memory == HT_MEMORY_HEAP) {
+        free(table);
+    }
+    else {
+        ht_pages_free(table, size * sizeof(HashSlot *), memory == HT_MEMORY_HUGE);
+    }
+}
+
+// Mapped arrays are only used by tables without a release hook, so they can be unmapped at once
+static void release_table(HashTable *ht, HashSlot **table, size_t size, unsigned char memory) {
+    if(memory == HT_MEMORY_HEAP) {
+        release_memory(ht, table);
+    }
+    else {
+        free_table(table, size, memory);
+    }
+}
+
+static bool is_slab_slot(HashTable *ht, HashSlot *slot) {
+    return (uintptr_t)slot >= (uintptr_t)ht->slab && (uintptr_t)slot < (uintptr_t)(ht->slab + ht->slab_count);
+}
+
+static void free_hash_slot(HashTable *ht, HashSlot *slot) {
+    if(slot->timer) {
+        ht_wheel_cancel(ht->wheel, slot->timer);
+        free(slot->timer);
+    }
+
+    // Bound tables never get a release hook (only the sharded table sets one, on tables of its own)
+    if(ht->arena) {
+        ht_node_arena_free(ht->arena, slot, sizeof(HashSlot));
+    }
+    else if(!is_slab_slot(ht, slot)) {
+        release_memory(ht, slot);
+    }
+}
+
+static bool is_expired(HashTable *ht, HashSlot *slot) {
+    return slot->timer && slot->timer->expires_at <= ht->wheel->clock;
+}
+
+#define HT_RESIZE_MIN_SLOTS_PER_WORKER (1 << 16)
+
+typedef struct {
+    HashSlot **overflow; // entries that did not fit in the worker's destination ranges
+    size_t overflow_count;
+    size_t overflow_capacity;
+    bool failed;
+} ResizeRange;
+
+typedef struct {
+    HashTable *ht;
+    HashSlot **new_table;
+    size_t new_size;
+    ResizeRange *ranges;
+} ResizeJob;
+
+static void place_slot(HashSlot **table, size_t size, HashSlot *slot) {
+    uint32_t index = hash(slot->key, size);
+
+    // Linear probing for an empty slot
+    while(table[index]) {
+        index = (index + 1) % size;
+    }
+
+    table[index] = slot;
+}
+
+static bool push_overflow(ResizeRange *range, HashSlot *slot) {
+    if(range->overflow_count == range->overflow_capacity) {
+        size_t capacity = range->overflow_capacity ? range->overflow_capacity * 2 : 64;
+        HashSlot **overflow = realloc(range->overflow, capacity * sizeof(HashSlot *));
+
+        if(!overflow) {
+            range->failed = true;
+            return false;
         }
+
+        range->overflow = overflow;
+        range->overflow_capacity = capacity;
     }
 
-    free(table);
-    table = NULL;
+    range->overflow[range->overflow_count++] = slot;
+
+    return true;
+}
+
+// Moves every entry whose old home bucket is in the worker's range [lo, hi).
+// Those entries sit between lo and the first empty slot at or after hi, and their new
+// homes lie in [lo, hi) or [lo + size, hi + size), which no other worker writes to.
+static void resize_range(void *ctx, unsigned worker, unsigned workers) {
+    ResizeJob *job = ctx;
+    ResizeRange *range = &job->ranges[worker];
+    HashSlot **old_table = job->ht->table;
+    size_t old_size = job->ht->size;
+    size_t lo = old_size / workers * worker;
+    size_t hi = worker + 1 == workers ? old_size : old_size / workers * (worker + 1);
+    size_t i = lo;
+
+    for(size_t step = 0; step < old_size; step++, i = (i + 1) % old_size) {
+        HashSlot *current = old_table[i];
+
+        if(!current && step >= hi - lo) {
+            break;
+        }
+        else if(!current || current == TOMBSTONE) {
+            continue;
+        }
+
+        uint32_t hash_value = ht_fnv1a(current->key);
+        size_t home = hash_value % old_size;
+
+        if(home < lo || home >= hi) {
+            continue;
+        }
+
+        size_t index = hash_value % job->new_size;
+        size_t end = index < old_size ? hi : hi + old_size;
+
+        while(index < end && job->new_table[index]) {
+            index++;
+        }
+
+        if(index < end) {
+            job->new_table[index] = current;
+        }
+        else if(!push_overflow(range, current)) {
+            return;
+        }
+    }
+}
+
+static bool rehash_parallel(HashTable *ht, HashSlot **new_table, size_t new_size, unsigned workers) {
+    ResizeRange *ranges = calloc(workers, sizeof(ResizeRange));
+
+    if(!ranges) {
+        mem_alloc_error("hash table resize workers");
+        return false;
+    }
+
+    ResizeJob job = {ht, new_table, new_size, ranges};
+    bool ok = true;
+
+    ht_parallel_run(workers, resize_range, &job);
+
+    for(unsigned i = 0; i < workers; i++) {
+        ok = ok && !ranges[i].failed;
+
+        for(size_t j = 0; ok && j < ranges[i].overflow_count; j++) {
+            place_slot(new_table, new_size, ranges[i].overflow[j]);
+        }
+
+        free(ranges[i].overflow);
+    }
+
+    free(ranges);
+
+    if(!ok) {
+        mem_alloc_error("hash table resize overflow");
+    }
+
+    return ok;
 }
 
 static bool ht_resize(HashTable *ht) {
@@ -99,64 +323,60 @@ static bool ht_resize(HashTable *ht) {
     }
     
     size_t new_size = ht->size * 2;
-    HashSlot **new_table = calloc(new_size, sizeof(HashSlot *));
+    unsigned char new_memory;
+    HashSlot **new_table = alloc_table(ht, new_size, &new_memory);
 
     if(!new_table) {
         return false;
     }
 
-    for(size_t i = 0; i < ht->size; i++) {
-        HashSlot *current = ht->table[i];
-
-        if(current && current != TOMBSTONE) {
-            uint32_t new_index = hash(current->key, new_size);
-
-            // Linear probing for an empty slot
-            while(new_table[new_index]) {
-                new_index = (new_index + 1) % new_size;
-            }
+    size_t max_workers = ht->size / HT_RESIZE_MIN_SLOTS_PER_WORKER;
+    unsigned workers = ht->resize_threads < max_workers ? ht->resize_threads : (unsigned)max_workers;
 
-            // Create a new hash slot
-            new_table[new_index] = create_hash_slot();
+    // Slots move over as they are, so their addresses (and their timers) stay valid
+    if(workers > 1) {
+        if(!rehash_parallel(ht, new_table, new_size, workers)) {
+            free_table(new_table, new_size, new_memory);
+            return false;
+        }
+    }
+    else {
+        for(size_t i = 0; i < ht->size; i++) {
+            HashSlot *current = ht->table[i];
 
-            if(!new_table[new_index]) {
-                free_new_table(new_table, new_size);
-                return false;
+            if(current && current != TOMBSTONE) {
+                place_slot(new_table, new_size, current);
             }
-
-            new_table[new_index]->key = current->key;
-            new_table[new_index]->value = current->value;
-            
-            free(current);
-            current = NULL;
         }
     }
 
-    free(ht->table);
-    ht->size = new_size;
-    ht->table = new_table;
+    release_table(ht, ht->table, ht->size, ht->table_memory);
+    ht->table_memory = new_memory;
+    __atomic_store_n(&ht->size, new_size, __ATOMIC_RELAXED);
+    __atomic_store_n(&ht->table, new_table, __ATOMIC_RELEASE);
 
     return true;
 }
 
-bool ht_set(HashTable *ht, const char *key, void *value) {
+// Inserts or updates key and returns its slot, or NULL on failure
+static HashSlot *ht_insert(HashTable *ht, const char *key, void *value) {
     if(!ht || ht->size == 0) {
         fputs("Cannot set a value for an unallocated hash table.\n", stderr);
-        return false;
+        return NULL;
     }
-    else if(!key || !value) {
-        fputs("Key or value cannot be NULL.\n", stderr);
-        return false;
+    else if(!key) {
+        fputs("Key cannot be NULL.\n", stderr);
+        return NULL;
     }
     else if(*key == '\0') {
         fputs("Key cannot be an empty string.\n", stderr);
-        return false;
+        return NULL;
     }
 
     if((float)(ht->element_count + 1) / (float)ht->size > LOAD_FACTOR_THRESHOLD) {
         if(!ht_resize(ht)) {
             fprintf(stderr, "Hash table resize failed, cannot insert key '%s'.\n", key);
-            return false;
+            return NULL;
         }
     }
     
@@ -170,32 +390,92 @@ bool ht_set(HashTable *ht, const char *key, void *value) {
             }
         }
         else if(strcmp(ht->table[index]->key, key) == 0) {
-            ht->table[index]->value = value;
-            return true;
+            __atomic_store_n(&ht->table[index]->value, value, __ATOMIC_RELAXED);
+            return ht->table[index];
         }
 
         index = (index + 1) % ht->size;
     }
 
     size_t insert_index = (first_tombstone != SIZE_MAX) ? first_tombstone : index;
-    HashSlot *slot = create_hash_slot();
+    HashSlot *slot = create_hash_slot(ht);
 
     if(!slot) {
-        return false;
+        return NULL;
     }
 
     slot->key = key;
     slot->value = value;
 
-    ht->table[insert_index] = slot;
+    // Publish the slot only once it is filled in, for readers that do not take the owner's lock
+    __atomic_store_n(&ht->table[insert_index], slot, __ATOMIC_RELEASE);
     ht->element_count++;
 
+    return slot;
+}
+
+bool ht_set(HashTable *ht, const char *key, void *value) {
+    HashSlot *slot = ht_insert(ht, key, value);
+
+    if(!slot) {
+        return false;
+    }
+
+    // A plain set makes the entry persistent again
+    if(slot->timer) {
+        ht_wheel_cancel(ht->wheel, slot->timer);
+        free(slot->timer);
+        slot->timer = NULL;
+    }
+
     return true;
 }
 
-const void *ht_get(HashTable *ht, const char *key) {
+bool ht_set_ttl(HashTable *ht, const char *key, void *value, uint64_t expires_at) {
+    if(ht && !ht->wheel) {
+        ht->wheel = ht_wheel_create();
+
+        if(!ht->wheel) {
+            mem_alloc_error("hash table timer wheel");
+            return false;
+        }
+    }
+
+    HashTimer *timer = malloc(sizeof(HashTimer));
+
+    if(!timer) {
+        mem_alloc_error("hash table timer");
+        return false;
+    }
+
+    HashSlot *slot = ht_insert(ht, key, value);
+
+    if(!slot) {
+        free(timer);
+        return false;
+    }
+
+    // Reuse the timer of an entry that already has a TTL
+    if(slot->timer) {
+        ht_wheel_cancel(ht->wheel, slot->timer);
+        free(timer);
+    }
+    else {
+        timer->data = slot;
+        slot->timer = timer;
+    }
+
+    slot->timer->expires_at = expires_at;
+    ht_wheel_schedule(ht->wheel, slot->timer);
+
+    return true;
+}
+
+// Returns the index of the slot holding key, or SIZE_MAX if the key is absent.
+// Expired entries that have not been reaped yet count as absent unless include_expired is set.
+static size_t ht_find(HashTable *ht, const char *key, bool include_expired) {
     if(!ht || ht->element_count == 0 || !key || *key == '\0') {
-        return NULL;
+        return SIZE_MAX;
     }
 
     uint32_t index = hash(key, ht->size);
@@ -203,53 +483,151 @@ const void *ht_get(HashTable *ht, const char *key) {
     // Linear probing to find the key
     while(ht->table[index]) {
         if(ht->table[index] != TOMBSTONE && strcmp(ht->table[index]->key, key) == 0) {
-            return ht->table[index]->value;
+            return (include_expired || !is_expired(ht, ht->table[index])) ? index : SIZE_MAX;
         }
 
         index = (index + 1) % ht->size;
     }
 
-    return NULL;
+    return SIZE_MAX;
+}
+
+const void *ht_get(HashTable *ht, const char *key) {
+    size_t index = ht_find(ht, key, false);
+
+    return index != SIZE_MAX ? ht->table[index]->value : NULL;
+}
+
+bool ht_try_get(HashTable *ht, const char *key, void **out) {
+    size_t index = ht_find(ht, key, false);
+
+    if(index == SIZE_MAX) {
+        return false;
+    }
+
+    if(out) {
+        *out = ht->table[index]->value;
+    }
+
+    return true;
+}
+
+static void ht_remove_index(HashTable *ht, size_t index) {
+    HashSlot *slot = ht->table[index];
+
+    __atomic_store_n(&ht->table[index], TOMBSTONE, __ATOMIC_RELEASE);
+    free_hash_slot(ht, slot);
+    ht->element_count--;
 }
 
 void ht_delete(HashTable *ht, const char *key) {
-    if(!ht || ht->element_count == 0 || !key || *key == '\0') {
+    size_t index = ht_find(ht, key, true);
+
+    if(index != SIZE_MAX) {
+        ht_remove_index(ht, index);
+    }
+}
+
+bool ht_has(HashTable *ht, const char *key) {
+    return ht_find(ht, key, false) != SIZE_MAX;
+}
+
+static void expire_slot(HashTimer *timer, void *ctx) {
+    HashTable *ht = ctx;
+    HashSlot *slot = timer->data;
+    size_t index = ht_find(ht, slot->key, true);
+
+    // The timer is already off the wheel
+    free(timer);
+    slot->timer = NULL;
+    ht_remove_index(ht, index);
+}
+
+void ht_set_resize_threads(HashTable *ht, unsigned threads) {
+    if(!ht) {
+        fputs("Hash table is NULL.\n", stderr);
         return;
     }
 
-    uint32_t index = hash(key, ht->size);
+    ht->resize_threads = threads == 0 ? ht_parallel_cpus() : threads;
+}
 
-    // Linear probing to find and delete the key
-    while(ht->table[index]) {
-        if(ht->table[index] != TOMBSTONE && strcmp(ht->table[index]->key, key) == 0) {
-            free(ht->table[index]);
-            ht->table[index] = TOMBSTONE;
-            ht->element_count--;
+bool ht_set_huge_pages(HashTable *ht, bool enabled) {
+    if(!ht || !ht->table) {
+        fputs("Cannot configure huge pages for an unallocated hash table.\n", stderr);
+        return false;
+    }
+    else if(enabled && ht->release) {
+        fputs("Huge pages are not available to tables with a release hook.\n", stderr);
+        return false;
+    }
 
-            return;
-        }
+    ht->huge_pages = enabled;
 
-        index = (index + 1) % ht->size;
+    unsigned char memory;
+    HashSlot **table = alloc_table(ht, ht->size, &memory);
+
+    // Nothing to move if the current array is already allocated the requested way
+    if(table && memory == ht->table_memory) {
+        free_table(table, ht->size, memory);
+        return true;
+    }
+    else if(!table) {
+        mem_alloc_error("hash table");
+        return false;
     }
+
+    // Same size, so every slot keeps its index
+    memcpy(table, ht->table, ht->size * sizeof(HashSlot *));
+    release_table(ht, ht->table, ht->size, ht->table_memory);
+    ht->table_memory = memory;
+    __atomic_store_n(&ht->table, table, __ATOMIC_RELEASE);
+
+    return true;
 }
 
-bool ht_has(HashTable *ht, const char *key) {
-    if(!ht || ht->element_count == 0 || !key || *key == '\0') {
+bool ht_own_memory(HashTable *ht, void *ptr) {
+    void **owned = realloc(ht->owned, (ht->owned_count + 1) * sizeof(void *));
+
+    if(!owned) {
+        mem_alloc_error("hash table owned memory");
         return false;
     }
 
-    uint32_t index = hash(key, ht->size);
+    owned[ht->owned_count++] = ptr;
+    ht->owned = owned;
 
-    // Linear probing to find the key
-    while(ht->table[index]) {
-        if(ht->table[index] != TOMBSTONE && strcmp(ht->table[index]->key, key) == 0) {
-            return true;
+    return true;
+}
+
+bool ht_reserve(HashTable *ht, size_t count) {
+    if(!ht || ht->size == 0) {
+        fputs("Cannot reserve room in an unallocated hash table.\n", stderr);
+        return false;
+    }
+
+    while((float)count / (float)ht->size > LOAD_FACTOR_THRESHOLD) {
+        if(!ht_resize(ht)) {
+            fprintf(stderr, "Hash table resize failed, cannot reserve room for %zu entries.\n", count);
+            return false;
         }
+    }
 
-        index = (index + 1) % ht->size;
+    return true;
+}
+
+const char *ht_stored_key(HashTable *ht, const char *key) {
+    size_t index = ht_find(ht, key, true);
+
+    return index != SIZE_MAX ? ht->table[index]->key : NULL;
+}
+
+size_t ht_expire_tick(HashTable *ht, uint64_t now, size_t budget) {
+    if(!ht || !ht->wheel) {
+        return 0;
     }
 
-    return false;
+    return ht_wheel_advance(ht->wheel, now, budget, expire_slot, ht);
 }
 
 void ht_free(HashTable **ht_ptr) {
@@ -260,6 +638,8 @@ void ht_free(HashTable **ht_ptr) {
     HashTable *ht = *ht_ptr;
 
     if(!ht->table || ht->size == 0) {
+        free(ht->wheel);
+        ht_node_arena_destroy(ht->arena);
         free(ht);
         *ht_ptr = NULL;
 
@@ -268,12 +648,30 @@ void ht_free(HashTable **ht_ptr) {
     
     for(size_t i = 0; i < ht->size; i++) {
         if(ht->table[i] && ht->table[i] != TOMBSTONE) {
-            free(ht->table[i]);
+            free(ht->table[i]->timer);
+
+            if(!ht->arena && !is_slab_slot(ht, ht->table[i])) {
+                free(ht->table[i]);
+            }
+
             ht->table[i] = NULL;
         }
     }
 
-    free(ht->table);
+    free(ht->slab);
+    ht->slab = NULL;
+    for(size_t i = 0; i < ht->owned_count; i++) {
+        free(ht->owned[i]);
+    }
+
+    free(ht->owned);
+    ht->owned = NULL;
+    ht->owned_count = 0;
+    free(ht->wheel);
+    ht->wheel = NULL;
+    ht_node_arena_destroy(ht->arena);
+    ht->arena = NULL;
+    free_table(ht->table, ht->size, ht->table_memory);
     ht->table = NULL;
     ht->size = 0;
     ht->element_count = 0;
@@ -300,7 +698,12 @@ size_t ht_count(HashTable *ht) {
     return ht->element_count;
 }
 
-HashTable *ht_init(size_t init_size) {
+HashTable *ht_init_numa(size_t init_size, HashNumaPolicy policy, unsigned node) {
+    if(policy == HT_NUMA_BIND && node >= ht_numa_node_count()) {
+        fprintf(stderr, "Cannot bind a hash table to NUMA node %u: no such node.\n", node);
+        return NULL;
+    }
+
     HashTable *ht = malloc(sizeof(HashTable));
 
     if(!ht) {
@@ -312,9 +715,21 @@ HashTable *ht_init(size_t init_size) {
 
     ht->size = init_size;
     ht->element_count = 0;
-    ht->table = calloc(init_size, sizeof(HashSlot *));
+    ht->wheel = NULL;
+    ht->release = NULL;
+    ht->resize_threads = 1;
+    ht->slab = NULL;
+    ht->slab_count = 0;
+    ht->owned = NULL;
+    ht->owned_count = 0;
+    ht->numa_policy = policy;
+    ht->numa_node = node;
+    ht->huge_pages = false;
+    ht->arena = policy == HT_NUMA_BIND ? ht_node_arena_create(node) : NULL;
+    ht->table = policy != HT_NUMA_BIND || ht->arena ? alloc_table(ht, init_size, &ht->table_memory) : NULL;
 
     if(!ht->table) {
+        ht_node_arena_destroy(ht->arena);
         free(ht);
         mem_alloc_error("hash table");
 
@@ -322,4 +737,238 @@ HashTable *ht_init(size_t init_size) {
     }
 
     return ht;
-}
\ No newline at end of file
+}
+
+HashTable *ht_init(size_t init_size) {
+    return ht_init_numa(init_size, HT_NUMA_DEFAULT, 0);
+}
+
+#define HT_BUILD_MIN_KEYS_PER_WORKER (1 << 16)
+
+typedef struct {
+    HashTable *ht;
+    const char *const *keys;
+    void *const *values;
+    size_t n;
+    unsigned workers;           // also the number of partitions
+    uint32_t *hashes;
+    size_t *order;              // key indices grouped by partition, in input order within each
+    size_t *cursors;            // [worker * workers + partition]: counts, then scatter positions
+    size_t *partition_start;    // workers + 1 bounds into order
+    size_t *placed;             // distinct keys each partition stored in place
+    ResizeRange *ranges;        // per-partition overflow
+    bool invalid_key;
+} BuildJob;
+
+static void build_bounds(BuildJob *job, unsigned partition, size_t *lo, size_t *hi) {
+    size_t width = job->ht->size / job->workers;
+
+    *lo = width * partition;
+    *hi = partition + 1 == job->workers ? job->ht->size : width * (partition + 1);
+}
+
+static unsigned build_partition(BuildJob *job, uint32_t hash_value) {
+    size_t partition = hash_value % job->ht->size / (job->ht->size / job->workers);
+
+    return partition < job->workers ? (unsigned)partition : job->workers - 1;
+}
+
+static void build_hash(void *ctx, unsigned worker, unsigned workers) {
+    BuildJob *job = ctx;
+    size_t *counts = &job->cursors[(size_t)worker * workers];
+
+    for(size_t i = job->n / workers * worker; i < (worker + 1 == workers ? job->n : job->n / workers * (worker + 1)); i++) {
+        const char *key = job->keys[i];
+
+        if(!key || *key == '\0') {
+            __atomic_store_n(&job->invalid_key, true, __ATOMIC_RELAXED);
+            return;
+        }
+
+        job->hashes[i] = ht_fnv1a(key);
+        counts[build_partition(job, job->hashes[i])]++;
+    }
+}
+
+static void build_scatter(void *ctx, unsigned worker, unsigned workers) {
+    BuildJob *job = ctx;
+    size_t *cursors = &job->cursors[(size_t)worker * workers];
+
+    for(size_t i = job->n / workers * worker; i < (worker + 1 == workers ? job->n : job->n / workers * (worker + 1)); i++) {
+        job->order[cursors[build_partition(job, job->hashes[i])]++] = i;
+    }
+}
+
+// Fills one partition's bucket range; runs entirely within it, so partitions need no locks
+static void build_fill(void *ctx, unsigned partition, unsigned workers) {
+    BuildJob *job = ctx;
+    HashSlot **table = job->ht->table;
+    size_t lo, hi;
+
+    (void)workers;
+    build_bounds(job, partition, &lo, &hi);
+
+    for(size_t j = job->partition_start[partition]; j < job->partition_start[partition + 1]; j++) {
+        size_t i = job->order[j];
+        size_t index = job->hashes[i] % job->ht->size;
+        bool updated = false;
+
+        while(index < hi && table[index]) {
+            if(strcmp(table[index]->key, job->keys[i]) == 0) {
+                table[index]->value = job->values ? job->values[i] : NULL;
+                updated = true;
+                break;
+            }
+
+            index++;
+        }
+
+        if(updated) {
+            continue;
+        }
+
+        HashSlot *slot = &job->ht->slab[i];
+
+        slot->key = job->keys[i];
+        slot->value = job->values ? job->values[i] : NULL;
+        slot->timer = NULL;
+
+        if(index < hi) {
+            table[index] = slot;
+            job->placed[partition]++;
+        }
+        else if(!push_overflow(&job->ranges[partition], slot)) {
+            return;
+        }
+    }
+}
+
+// Places an overflowed entry with ordinary probing, or updates the earlier copy of its key
+static void build_place_overflow(HashTable *ht, HashSlot *slot) {
+    uint32_t index = hash(slot->key, ht->size);
+
+    while(ht->table[index]) {
+        if(strcmp(ht->table[index]->key, slot->key) == 0) {
+            ht->table[index]->value = slot->value;
+            return;
+        }
+
+        index = (index + 1) % ht->size;
+    }
+
+    ht->table[index] = slot;
+    ht->element_count++;
+}
+
+static bool build_table(BuildJob *job) {
+    HashTable *ht = job->ht;
+    unsigned workers = job->workers;
+
+    ht_parallel_run(workers, build_hash, job);
+
+    if(job->invalid_key) {
+        fputs("Cannot build a hash table: keys cannot be NULL or empty strings.\n", stderr);
+        return false;
+    }
+
+    // Turn the per-worker partition counts into scatter positions. Worker-major order
+    // within a partition keeps the keys in input order.
+    size_t position = 0;
+
+    for(unsigned partition = 0; partition < workers; partition++) {
+        job->partition_start[partition] = position;
+
+        for(unsigned worker = 0; worker < workers; worker++) {
+            size_t count = job->cursors[(size_t)worker * workers + partition];
+
+            job->cursors[(size_t)worker * workers + partition] = position;
+            position += count;
+        }
+    }
+
+    job->partition_start[workers] = position;
+
+    ht_parallel_run(workers, build_scatter, job);
+    ht_parallel_run(workers, build_fill, job);
+
+    for(unsigned partition = 0; partition < workers; partition++) {
+        if(job->ranges[partition].failed) {
+            mem_alloc_error("hash table build overflow");
+            return false;
+        }
+
+        ht->element_count += job->placed[partition];
+    }
+
+    for(unsigned partition = 0; partition < workers; partition++) {
+        for(size_t j = 0; j < job->ranges[partition].overflow_count; j++) {
+            build_place_overflow(ht, job->ranges[partition].overflow[j]);
+        }
+    }
+
+    return true;
+}
+
+HashTable *ht_build(const char *const *keys, void *const *values, size_t n, unsigned threads) {
+    if(!keys && n > 0) {
+        fputs("Cannot build a hash table from NULL keys.\n", stderr);
+        return NULL;
+    }
+    else if(n > (size_t)(SIZE_MAX * LOAD_FACTOR_THRESHOLD) / sizeof(HashSlot *)) {
+        fputs("Hash table build failed: too many keys.\n", stderr);
+        return NULL;
+    }
+
+    threads = threads == 0 ? ht_parallel_cpus() : threads;
+
+    size_t max_workers = n / HT_BUILD_MIN_KEYS_PER_WORKER;
+    unsigned workers = threads < max_workers ? threads : (max_workers > 1 ? (unsigned)max_workers : 1);
+    HashTable *ht = ht_init((size_t)(n / LOAD_FACTOR_THRESHOLD) + 1);
+
+    if(!ht) {
+        return NULL;
+    }
+
+    ht->resize_threads = threads;
+
+    if(n == 0) {
+        return ht;
+    }
+
+    BuildJob job = {ht, keys, values, n, workers};
+
+    ht->slab = malloc(n * sizeof(HashSlot));
+    job.hashes = malloc(n * sizeof(uint32_t));
+    job.order = malloc(n * sizeof(size_t));
+    job.cursors = calloc((size_t)workers * workers, sizeof(size_t));
+    job.partition_start = malloc((workers + 1) * sizeof(size_t));
+    job.placed = calloc(workers, sizeof(size_t));
+    job.ranges = calloc(workers, sizeof(ResizeRange));
+
+    bool ok = ht->slab && job.hashes && job.order && job.cursors && job.partition_start && job.placed && job.ranges;
+
+    if(ok) {
+        ht->slab_count = n;
+        ok = build_table(&job);
+    }
+    else {
+        mem_alloc_error("hash table build");
+    }
+
+    for(unsigned partition = 0; job.ranges && partition < workers; partition++) {
+        free(job.ranges[partition].overflow);
+    }
+
+    free(job.hashes);
+    free(job.order);
+    free(job.cursors);
+    free(job.partition_start);
+    free(job.placed);
+    free(job.ranges);
+
+    if(!ok) {
+        ht_free(&ht);
+    }
+
+    return ht;
+}
@@ -2,29 +2,60 @@
 #define HASH_TABLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define LOAD_FACTOR_THRESHOLD 0.7
 #define TOMBSTONE ((HashSlot *)(intptr_t)-1)
 
+// Where the slot array's memory is placed on NUMA machines
+typedef enum {
+    HT_NUMA_DEFAULT,    // wherever the allocator puts it
+    HT_NUMA_INTERLEAVE, // pages spread round-robin over all nodes
+    HT_NUMA_BIND        // all pages on one node
+} HashNumaPolicy;
+
+struct HashTimer;
+struct HashTimerWheel;
+
 typedef struct {
     const char *key;
     void *value;
+    struct HashTimer *timer; // expiry of a TTL entry, NULL if the entry never expires
 } HashSlot;
 
 typedef struct HashTable {
     size_t size;
     size_t element_count;
     HashSlot **table;
+    struct HashTimerWheel *wheel; // created by the first ht_set_ttl
+    void (*release)(void *ptr);   // frees removed slots and replaced slot arrays; NULL means free()
+    unsigned resize_threads;      // workers that rehash a large table on resize; 1 means serial
+    HashSlot *slab;               // slots allocated in one block by ht_build; never freed one by one
+    size_t slab_count;
+    void **owned;                 // blocks holding keys and values loaded from files, freed by ht_free
+    size_t owned_count;
+    HashNumaPolicy numa_policy;   // placement of the slot array, kept across resizes
+    unsigned numa_node;           // node of HT_NUMA_BIND
+    bool huge_pages;              // back slot arrays of at least one huge page with huge pages
+    unsigned char table_memory;   // how the current slot array was allocated
+    struct HashNodeArena *arena;  // node-local memory for the slots of HT_NUMA_BIND tables
 } HashTable;
 
 bool ht_set(HashTable *ht, const char *key, void *value);
+bool ht_set_ttl(HashTable *ht, const char *key, void *value, uint64_t expires_at);
+size_t ht_expire_tick(HashTable *ht, uint64_t now, size_t budget);
+void ht_set_resize_threads(HashTable *ht, unsigned threads);
+bool ht_set_huge_pages(HashTable *ht, bool enabled);
 const void *ht_get(HashTable *ht, const char *key);
+bool ht_try_get(HashTable *ht, const char *key, void **out);
 void ht_delete(HashTable *ht, const char *key);
 bool ht_has(HashTable *ht, const char *key);
 void ht_free(HashTable **ht_ptr);
 size_t ht_size(HashTable *ht);
 size_t ht_count(HashTable *ht);
 HashTable *ht_init(size_t initSize);
+HashTable *ht_init_numa(size_t init_size, HashNumaPolicy policy, unsigned node);
+HashTable *ht_build(const char *const *keys, void *const *values, size_t n, unsigned threads);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,809 @@
+/*
+    C++ Hash Map
+
+    Description:
+    A C++17 `unordered_map`-like container built on the library's open addressing
+    scheme: one metadata byte per slot (empty, tombstone, or full with 7 bits of the
+    hash), linear probing over a power-of-two slot array, and the same 0.7 load
+    factor, counting tombstones. Entries are stored inline in the slot array, so a
+    lookup touches the metadata byte and, on a tag match, the entry itself, with no
+    node to chase.
+
+    Compared to wrapping `HashTable` by hand:
+    - The map owns its keys and values and releases them in its destructor (RAII).
+    - Values may be move-only types such as `std::unique_ptr`.
+    - `try_emplace`, `emplace` and `operator[]` construct values in place, from the
+      caller's arguments, without temporaries.
+    - With the default hash and equality, `std::string` keys can be looked up with a
+      `std::string_view` or a `const char *` without constructing a `std::string`.
+    - Memory comes from the allocator parameter, rebound for entries and metadata.
+
+    Strings are hashed with FNV-1a like the C table, widened to 64 bits. Every hash is
+    spread with Fibonacci hashing, so identity hashes such as `std::hash<int>` work well.
+
+    Differences from `std::unordered_map`: there is no bucket interface, and since
+    entries live in the slot array, any insertion may move them and invalidates
+    iterators, pointers and references. Erasing only invalidates the erased entry.
+    Growing copies keys, since they are const, and moves values, or copies them when
+    their move constructor may throw. If that still throws during a resize, the map
+    keeps the entries moved so far, with the entry being inserted, and destroys the
+    rest; size() stays exact and no memory is lost. The entry being inserted is built
+    before any entry moves, so its arguments may refer to entries of the map itself.
+*/
+
+#ifndef HASH_TABLE_HPP
+#define HASH_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ht {
+
+// FNV-1a (Fowler-Noll-Vo), 64-bit
+inline std::uint64_t fnv1a(std::string_view key) noexcept {
+    std::uint64_t hash_value = 14695981039346656037ULL;
+
+    for(unsigned char c : key) {
+        hash_value ^= c;
+        hash_value *= 1099511628211ULL;
+    }
+
+    return hash_value;
+}
+
+namespace detail {
+
+// K only makes the check depend on the member template being instantiated
+template<class F, class K, class = void>
+struct is_transparent : std::false_type {};
+
+template<class F, class K>
+struct is_transparent<F, K, std::void_t<typename F::is_transparent>> : std::true_type {};
+
+} // namespace detail
+
+template<class Key>
+struct hash : std::hash<Key> {};
+
+// Transparent: hashes std::string, std::string_view and const char * alike
+template<>
+struct hash<std::string> {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view key) const noexcept {
+        return static_cast<std::size_t>(fnv1a(key));
+    }
+};
+
+template<>
+struct hash<std::string_view> : hash<std::string> {};
+
+template<class Key, class T, class Hash = hash<Key>, class KeyEqual = std::equal_to<>,
+         class Allocator = std::allocator<std::pair<const Key, T>>>
+class hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+
+private:
+    using value_traits = std::allocator_traits<Allocator>;
+    using meta_allocator = typename value_traits::template rebind_alloc<std::uint8_t>;
+    using meta_traits = std::allocator_traits<meta_allocator>;
+
+    static constexpr std::uint8_t empty_slot = 0x00;
+    static constexpr std::uint8_t tombstone = 0x01;
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    static constexpr size_type min_capacity = 8;
+
+    // Heterogeneous lookup needs both the hash and the equality to opt in
+    template<class K>
+    using if_transparent = std::enable_if_t<detail::is_transparent<Hash, K>::value &&
+                                            detail::is_transparent<KeyEqual, K>::value, int>;
+
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename hash_map::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+        basic_iterator() = default;
+
+        // iterator converts to const_iterator
+        template<bool OtherConst, class = std::enable_if_t<Const && !OtherConst>>
+        basic_iterator(const basic_iterator<OtherConst> &other) noexcept
+            : meta_(other.meta_), slots_(other.slots_), index_(other.index_), capacity_(other.capacity_) {}
+
+        reference operator*() const noexcept {
+            return slots_[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &slots_[index_];
+        }
+
+        basic_iterator &operator++() noexcept {
+            index_++;
+            skip_free();
+
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept {
+            basic_iterator previous = *this;
+
+            ++*this;
+
+            return previous;
+        }
+
+        friend bool operator==(const basic_iterator &a, const basic_iterator &b) noexcept {
+            return a.index_ == b.index_ && a.slots_ == b.slots_;
+        }
+
+        friend bool operator!=(const basic_iterator &a, const basic_iterator &b) noexcept {
+            return !(a == b);
+        }
+
+    private:
+        friend class hash_map;
+
+        basic_iterator(const std::uint8_t *meta, value_type *slots, size_type index, size_type capacity) noexcept
+            : meta_(meta), slots_(slots), index_(index), capacity_(capacity) {}
+
+        void skip_free() noexcept {
+            while(index_ < capacity_ && !(meta_[index_] & 0x80)) {
+                index_++;
+            }
+        }
+
+        const std::uint8_t *meta_ = nullptr;
+        value_type *slots_ = nullptr;
+        size_type index_ = 0;
+        size_type capacity_ = 0;
+    };
+
+public:
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    hash_map() : hash_map(0) {}
+
+    explicit hash_map(size_type init_size, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual(),
+                      const Allocator &alloc = Allocator())
+        : hash_(hash), equal_(equal), alloc_(alloc) {
+        reserve(init_size);
+    }
+
+    explicit hash_map(const Allocator &alloc) : hash_map(0, Hash(), KeyEqual(), alloc) {}
+
+    hash_map(std::initializer_list<value_type> values, size_type init_size = 0, const Hash &hash = Hash(),
+             const KeyEqual &equal = KeyEqual(), const Allocator &alloc = Allocator())
+        : hash_map(init_size, hash, equal, alloc) {
+        reserve(values.size());
+
+        for(const value_type &value : values) {
+            insert(value);
+        }
+    }
+
+    hash_map(const hash_map &other)
+        : hash_map(other, value_traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    hash_map(const hash_map &other, const Allocator &alloc) : hash_(other.hash_), equal_(other.equal_), alloc_(alloc) {
+        // The destructor does not run for a constructor that throws
+        try {
+            copy_slots(other);
+        }
+        catch(...) {
+            release();
+            throw;
+        }
+    }
+
+    hash_map(hash_map &&other) noexcept
+        : hash_(std::move(other.hash_)), equal_(std::move(other.equal_)), alloc_(std::move(other.alloc_)) {
+        steal(other);
+    }
+
+    hash_map &operator=(const hash_map &other) {
+        if(this != &other) {
+            release();
+
+            if constexpr(value_traits::propagate_on_container_copy_assignment::value) {
+                alloc_ = other.alloc_;
+            }
+
+            hash_ = other.hash_;
+            equal_ = other.equal_;
+            copy_slots(other);
+        }
+
+        return *this;
+    }
+
+    hash_map &operator=(hash_map &&other) noexcept(value_traits::propagate_on_container_move_assignment::value ||
+                                                   value_traits::is_always_equal::value) {
+        if(this == &other) {
+            return *this;
+        }
+
+        release();
+        hash_ = std::move(other.hash_);
+        equal_ = std::move(other.equal_);
+
+        if constexpr(value_traits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(other.alloc_);
+            steal(other);
+        }
+        else if(alloc_ == other.alloc_) {
+            steal(other);
+        }
+        else {
+            // Memory of another allocator cannot be taken over; move the entries one by one
+            reserve(other.count_);
+
+            for(value_type &value : other) {
+                try_emplace(value.first, std::move(value.second));
+            }
+
+            other.clear();
+        }
+
+        return *this;
+    }
+
+    ~hash_map() {
+        release();
+    }
+
+    iterator begin() noexcept {
+        iterator it(meta_, slots_, 0, capacity_);
+
+        it.skip_free();
+
+        return it;
+    }
+
+    const_iterator begin() const noexcept {
+        const_iterator it(meta_, slots_, 0, capacity_);
+
+        it.skip_free();
+
+        return it;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(meta_, slots_, capacity_, capacity_);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(meta_, slots_, capacity_, capacity_);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    bool empty() const noexcept {
+        return count_ == 0;
+    }
+
+    size_type size() const noexcept {
+        return count_;
+    }
+
+    // Number of slots
+    size_type capacity() const noexcept {
+        return capacity_;
+    }
+
+    float load_factor() const noexcept {
+        return capacity_ ? static_cast<float>(count_) / static_cast<float>(capacity_) : 0.0f;
+    }
+
+    void clear() noexcept {
+        for(size_type i = 0; i < capacity_; i++) {
+            if(meta_[i] & 0x80) {
+                value_traits::destroy(alloc_, &slots_[i]);
+            }
+        }
+
+        if(meta_) {
+            std::memset(meta_, empty_slot, capacity_);
+        }
+
+        count_ = 0;
+        tombstones_ = 0;
+    }
+
+    // Makes room for count entries without further resizing
+    void reserve(size_type count) {
+        if(count == 0) {
+            return;
+        }
+
+        size_type capacity = min_capacity;
+
+        while(capacity * 7 < count * 10) {
+            capacity *= 2;
+        }
+
+        if(capacity > capacity_) {
+            rehash_to(capacity);
+        }
+    }
+
+    std::pair<iterator, bool> insert(const value_type &value) {
+        return try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type &&value) {
+        // The key is const, so it is copied rather than moved
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+
+        if(!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+
+        return result;
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value) {
+        auto result = try_emplace(std::move(key), std::forward<M>(value));
+
+        if(!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+
+        return result;
+    }
+
+    // Constructs the value from args in its slot, only if key is absent
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &key, Args &&...args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(key_type &&key, Args &&...args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template<class K, class V>
+    std::pair<iterator, bool> emplace(K &&key, V &&value) {
+        return emplace_key(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    std::pair<iterator, bool> emplace(value_type &&value) {
+        return insert(std::move(value));
+    }
+
+    T &operator[](const key_type &key) {
+        return try_emplace(key).first->second;
+    }
+
+    T &operator[](key_type &&key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    T &at(const key_type &key) {
+        return at_impl(key);
+    }
+
+    const T &at(const key_type &key) const {
+        return const_cast<hash_map *>(this)->at_impl(key);
+    }
+
+    template<class K, if_transparent<K> = 0>
+    T &at(const K &key) {
+        return at_impl(key);
+    }
+
+    template<class K, if_transparent<K> = 0>
+    const T &at(const K &key) const {
+        return const_cast<hash_map *>(this)->at_impl(key);
+    }
+
+    iterator find(const key_type &key) {
+        return make_iterator(find_index(key));
+    }
+
+    const_iterator find(const key_type &key) const {
+        return make_iterator(find_index(key));
+    }
+
+    template<class K, if_transparent<K> = 0>
+    iterator find(const K &key) {
+        return make_iterator(find_index(key));
+    }
+
+    template<class K, if_transparent<K> = 0>
+    const_iterator find(const K &key) const {
+        return make_iterator(find_index(key));
+    }
+
+    bool contains(const key_type &key) const {
+        return find_index(key) != npos;
+    }
+
+    template<class K, if_transparent<K> = 0>
+    bool contains(const K &key) const {
+        return find_index(key) != npos;
+    }
+
+    size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    template<class K, if_transparent<K> = 0>
+    size_type count(const K &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    size_type erase(const key_type &key) {
+        return erase_index(find_index(key));
+    }
+
+    template<class K, if_transparent<K> = 0>
+    size_type erase(const K &key) {
+        return erase_index(find_index(key));
+    }
+
+    iterator erase(const_iterator position) {
+        erase_index(position.index_);
+
+        iterator next(meta_, slots_, position.index_, capacity_);
+
+        next.skip_free();
+
+        return next;
+    }
+
+    iterator erase(iterator position) {
+        return erase(const_iterator(position));
+    }
+
+    void swap(hash_map &other) noexcept {
+        using std::swap;
+
+        if constexpr(value_traits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        }
+
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        swap(meta_, other.meta_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(bits_, other.bits_);
+        swap(count_, other.count_);
+        swap(tombstones_, other.tombstones_);
+    }
+
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+    hasher hash_function() const {
+        return hash_;
+    }
+
+    key_equal key_eq() const {
+        return equal_;
+    }
+
+private:
+    // Fibonacci hashing: the top bits of the product index the table, the low bits make the tag
+    template<class K>
+    std::uint64_t mix(const K &key) const {
+        return static_cast<std::uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    size_type home(std::uint64_t mixed) const noexcept {
+        return static_cast<size_type>(mixed >> (64 - bits_));
+    }
+
+    static std::uint8_t tag(std::uint64_t mixed) noexcept {
+        return static_cast<std::uint8_t>(0x80 | (mixed & 0x7f));
+    }
+
+    template<class K>
+    size_type find_index(const K &key) const {
+        if(count_ == 0) {
+            return npos;
+        }
+
+        std::uint64_t mixed = mix(key);
+        std::uint8_t key_tag = tag(mixed);
+        size_type mask = capacity_ - 1;
+
+        for(size_type index = home(mixed); meta_[index] != empty_slot; index = (index + 1) & mask) {
+            if(meta_[index] == key_tag && equal_(slots_[index].first, key)) {
+                return index;
+            }
+        }
+
+        return npos;
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace_key(K &&key, Args &&...args) {
+        size_type index = find_index(key);
+
+        if(index != npos) {
+            return {make_iterator(index), false};
+        }
+
+        std::uint64_t mixed = mix(key);
+
+        if((count_ + tombstones_ + 1) * 10 > capacity_ * 7) {
+            // Mostly tombstones: rebuilding at the same size is enough
+            return emplace_rehashed(
+                (count_ + 1) * 10 > capacity_ * 7 / 2 ? (capacity_ ? capacity_ * 2 : min_capacity) : capacity_, mixed,
+                std::forward<K>(key), std::forward<Args>(args)...);
+        }
+
+        index = home(mixed);
+
+        while(meta_[index] & 0x80) {
+            index = (index + 1) & (capacity_ - 1);
+        }
+
+        value_traits::construct(alloc_, &slots_[index], std::piecewise_construct,
+                                std::forward_as_tuple(std::forward<K>(key)),
+                                std::forward_as_tuple(std::forward<Args>(args)...));
+
+        if(meta_[index] == tombstone) {
+            tombstones_--;
+        }
+
+        meta_[index] = tag(mixed);
+        count_++;
+
+        return {make_iterator(index), true};
+    }
+
+    // Builds the new entry in a fresh slot array of capacity slots, then moves the others in.
+    // Until the entry is built the old array is untouched, so arguments that refer into the
+    // map stay valid, and a constructor that throws leaves the map as it was.
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace_rehashed(size_type capacity, std::uint64_t mixed, K &&key, Args &&...args) {
+        std::uint8_t *meta;
+        value_type *slots;
+
+        allocate_arrays(capacity, meta, slots);
+
+        size_type index = static_cast<size_type>(mixed >> (64 - bits_for(capacity)));
+
+        try {
+            value_traits::construct(alloc_, &slots[index], std::piecewise_construct,
+                                    std::forward_as_tuple(std::forward<K>(key)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        catch(...) {
+            deallocate(meta, slots, capacity);
+            throw;
+        }
+
+        meta[index] = tag(mixed);
+        adopt_arrays(meta, slots, capacity, 1);
+
+        return {make_iterator(index), true};
+    }
+
+    template<class K>
+    T &at_impl(const K &key) {
+        size_type index = find_index(key);
+
+        if(index == npos) {
+            throw std::out_of_range("ht::hash_map::at: key not found");
+        }
+
+        return slots_[index].second;
+    }
+
+    size_type erase_index(size_type index) {
+        if(index == npos) {
+            return 0;
+        }
+
+        value_traits::destroy(alloc_, &slots_[index]);
+        meta_[index] = tombstone;
+        count_--;
+        tombstones_++;
+
+        return 1;
+    }
+
+    iterator make_iterator(size_type index) const noexcept {
+        return iterator(meta_, slots_, index == npos ? capacity_ : index, capacity_);
+    }
+
+    static unsigned bits_for(size_type capacity) noexcept {
+        unsigned bits = 0;
+
+        while((size_type(1) << bits) < capacity) {
+            bits++;
+        }
+
+        return bits;
+    }
+
+    // Allocates a slot array of capacity slots with all of them empty
+    void allocate_arrays(size_type capacity, std::uint8_t *&meta, value_type *&slots) {
+        meta_allocator meta_alloc(alloc_);
+
+        meta = meta_traits::allocate(meta_alloc, capacity);
+
+        try {
+            slots = std::addressof(*value_traits::allocate(alloc_, capacity));
+        }
+        catch(...) {
+            meta_traits::deallocate(meta_alloc, meta, capacity);
+            throw;
+        }
+
+        std::memset(meta, empty_slot, capacity);
+    }
+
+    // Moves every entry into meta and slots, a fresh array already holding present entries,
+    // dropping tombstones, and frees the old array. If an entry cannot be moved, the entries
+    // not moved yet are destroyed and the exception propagates.
+    void adopt_arrays(std::uint8_t *meta, value_type *slots, size_type capacity, size_type present) {
+        std::uint8_t *old_meta = meta_;
+        value_type *old_slots = slots_;
+        size_type old_capacity = capacity_;
+
+        meta_ = meta;
+        slots_ = slots;
+        capacity_ = capacity;
+        bits_ = bits_for(capacity);
+        tombstones_ = 0;
+        count_ = present;
+
+        for(size_type i = 0; i < old_capacity; i++) {
+            if(!(old_meta[i] & 0x80)) {
+                continue;
+            }
+
+            std::uint64_t mixed = mix(old_slots[i].first);
+            size_type index = home(mixed);
+
+            while(meta_[index] != empty_slot) {
+                index = (index + 1) & (capacity - 1);
+            }
+
+            try {
+                value_traits::construct(alloc_, &slots_[index], std::piecewise_construct,
+                                        std::forward_as_tuple(old_slots[i].first),
+                                        std::forward_as_tuple(std::move_if_noexcept(old_slots[i].second)));
+            }
+            catch(...) {
+                for(size_type j = i; j < old_capacity; j++) {
+                    if(old_meta[j] & 0x80) {
+                        value_traits::destroy(alloc_, &old_slots[j]);
+                    }
+                }
+
+                deallocate(old_meta, old_slots, old_capacity);
+                throw;
+            }
+
+            value_traits::destroy(alloc_, &old_slots[i]);
+            meta_[index] = tag(mixed);
+            count_++;
+        }
+
+        deallocate(old_meta, old_slots, old_capacity);
+    }
+
+    // Moves every entry into a fresh slot array of capacity slots, dropping tombstones
+    void rehash_to(size_type capacity) {
+        std::uint8_t *meta;
+        value_type *slots;
+
+        allocate_arrays(capacity, meta, slots);
+        adopt_arrays(meta, slots, capacity, 0);
+    }
+
+    // Same hash, same capacity: every entry goes to the slot it has in other
+    void copy_slots(const hash_map &other) {
+        if(other.capacity_ == 0) {
+            return;
+        }
+
+        rehash_to(other.capacity_);
+
+        for(size_type i = 0; i < other.capacity_; i++) {
+            if(other.meta_[i] & 0x80) {
+                value_traits::construct(alloc_, &slots_[i], other.slots_[i]);
+                meta_[i] = other.meta_[i];
+                count_++;
+            }
+            else if(other.meta_[i] == tombstone) {
+                meta_[i] = tombstone;
+                tombstones_++;
+            }
+        }
+    }
+
+    void deallocate(std::uint8_t *meta, value_type *slots, size_type capacity) {
+        if(!meta) {
+            return;
+        }
+
+        meta_allocator meta_alloc(alloc_);
+
+        meta_traits::deallocate(meta_alloc, meta, capacity);
+        value_traits::deallocate(alloc_, slots, capacity);
+    }
+
+    void release() noexcept {
+        clear();
+        deallocate(meta_, slots_, capacity_);
+        meta_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        bits_ = 0;
+    }
+
+    void steal(hash_map &other) noexcept {
+        meta_ = std::exchange(other.meta_, nullptr);
+        slots_ = std::exchange(other.slots_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        bits_ = std::exchange(other.bits_, 0);
+        count_ = std::exchange(other.count_, 0);
+        tombstones_ = std::exchange(other.tombstones_, 0);
+    }
+
+    Hash hash_;
+    KeyEqual equal_;
+    Allocator alloc_;
+    std::uint8_t *meta_ = nullptr;
+    value_type *slots_ = nullptr;
+    size_type capacity_ = 0;
+    unsigned bits_ = 0;
+    size_type count_ = 0;
+    size_type tombstones_ = 0;
+};
+
+template<class Key, class T, class Hash, class KeyEqual, class Allocator>
+void swap(hash_map<Key, T, Hash, KeyEqual, Allocator> &a, hash_map<Key, T, Hash, KeyEqual, Allocator> &b) noexcept {
+    a.swap(b);
+}
+
+} // namespace ht
+
+#endif
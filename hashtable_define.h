@@ -0,0 +1,282 @@
+/*
+    Type-Specialized Hash Tables
+    
+    Description:
+    Header-only generator for hash tables specialized to one key type and one value
+    type. `HT_DEFINE(name, KeyT, ValT, hash_fn, eq_fn)` stamps out a table type `name`
+    that stores keys and values inline in its slot array and a set of static inline
+    functions for it. The hash and equality functions are called directly, so the
+    compiler inlines them into the probe loop, and values of any size are stored
+    without a separate allocation or a `void *` cast.
+
+    `hash_fn` is `uint64_t hash_fn(KeyT key)` and `eq_fn` is `bool eq_fn(KeyT a, KeyT b)`.
+    Ready-made ones cover integers (`ht_hash_u64`, `ht_eq_u64`) and strings
+    (`ht_hash_str`, `ht_eq_str`). The hash is spread over the table with Fibonacci
+    hashing, so even an identity hash of integer keys distributes well.
+
+    The layout follows the hash set: one metadata byte per slot (empty, tombstone, or
+    full with 7 bits of the hash), linear probing over a power-of-two slot array, and
+    the same 0.7 load factor, counting tombstones. Keys and values are copied in; as
+    with the hash table, string keys are stored as pointers that must stay valid.
+
+    Generated functions, for `HT_DEFINE(wordcount, const char *, int, ...)`:
+        wordcount *wordcount_init(size_t init_size);
+        bool wordcount_set(wordcount *t, const char *key, int value);
+        int *wordcount_get(wordcount *t, const char *key);  // NULL if absent
+        bool wordcount_try_get(wordcount *t, const char *key, int *out);
+        bool wordcount_delete(wordcount *t, const char *key);
+        bool wordcount_has(wordcount *t, const char *key);
+        size_t wordcount_count(wordcount *t);
+        void wordcount_free(wordcount **t_ptr);
+*/
+
+#ifndef HASH_TABLE_DEFINE_H
+#define HASH_TABLE_DEFINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HT_DEFINE_EMPTY 0x00
+#define HT_DEFINE_TOMBSTONE 0x01
+
+static inline uint64_t ht_hash_u64(uint64_t key) {
+    return key;
+}
+
+static inline bool ht_eq_u64(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+// FNV-1a (Fowler-Noll-Vo), 64-bit
+static inline uint64_t ht_hash_str(const char *key) {
+    uint64_t hash_value = 14695981039346656037ULL;
+
+    for(size_t i = 0; key[i] != '\0'; i++) {
+        hash_value ^= (unsigned char)key[i];
+        hash_value *= 1099511628211ULL;
+    }
+
+    return hash_value;
+}
+
+static inline bool ht_eq_str(const char *a, const char *b) {
+    return strcmp(a, b) == 0;
+}
+
+#define HT_DEFINE(name, KeyT, ValT, hash_fn, eq_fn) \
+    typedef struct { \
+        KeyT key; \
+        ValT value; \
+    } name##_entry; \
+    \
+    typedef struct name { \
+        size_t size; /* always a power of two */ \
+        unsigned bits; \
+        size_t element_count; \
+        size_t tombstone_count; \
+        uint8_t *meta; \
+        name##_entry *entries; \
+    } name; \
+    \
+    /* Fibonacci hashing: the top bits of the product index the table, the low bits make the tag */ \
+    static inline uint64_t name##_mix(KeyT key) { \
+        return (uint64_t)hash_fn(key) * 0x9e3779b97f4a7c15ULL; \
+    } \
+    \
+    static inline size_t name##_home(name *t, uint64_t mixed) { \
+        return t->bits ? (size_t)(mixed >> (64 - t->bits)) : 0; \
+    } \
+    \
+    static inline uint8_t name##_tag(uint64_t mixed) { \
+        return (uint8_t)(0x80 | (mixed & 0x7f)); \
+    } \
+    \
+    static inline bool name##_alloc(name *t, size_t size) { \
+        uint8_t *meta = (uint8_t *)calloc(size, sizeof(uint8_t)); \
+        name##_entry *entries = (name##_entry *)malloc(size * sizeof(name##_entry)); \
+        \
+        if(!meta || !entries) { \
+            free(meta); \
+            free(entries); \
+            fputs("Cannot allocate a memory for " #name " slots.\n", stderr); \
+            return false; \
+        } \
+        \
+        t->meta = meta; \
+        t->entries = entries; \
+        t->size = size; \
+        t->bits = 0; \
+        t->tombstone_count = 0; \
+        \
+        while(((size_t)1 << t->bits) < size) { \
+            t->bits++; \
+        } \
+        \
+        return true; \
+    } \
+    \
+    /* Returns the slot holding key, or SIZE_MAX */ \
+    static inline size_t name##_find(name *t, KeyT key) { \
+        uint64_t mixed = name##_mix(key); \
+        uint8_t tag = name##_tag(mixed); \
+        size_t mask = t->size - 1; \
+        \
+        for(size_t index = name##_home(t, mixed); t->meta[index] != HT_DEFINE_EMPTY; index = (index + 1) & mask) { \
+            if(t->meta[index] == tag && eq_fn(t->entries[index].key, key)) { \
+                return index; \
+            } \
+        } \
+        \
+        return SIZE_MAX; \
+    } \
+    \
+    /* Moves every entry into a fresh slot array of new_size slots, dropping tombstones */ \
+    static inline bool name##_rehash(name *t, size_t new_size) { \
+        uint8_t *old_meta = t->meta; \
+        name##_entry *old_entries = t->entries; \
+        size_t old_size = t->size; \
+        \
+        if(!name##_alloc(t, new_size)) { \
+            return false; \
+        } \
+        \
+        for(size_t i = 0; i < old_size; i++) { \
+            if(old_meta[i] & 0x80) { \
+                uint64_t mixed = name##_mix(old_entries[i].key); \
+                size_t index = name##_home(t, mixed); \
+                \
+                while(t->meta[index] != HT_DEFINE_EMPTY) { \
+                    index = (index + 1) & (new_size - 1); \
+                } \
+                \
+                t->meta[index] = name##_tag(mixed); \
+                t->entries[index] = old_entries[i]; \
+            } \
+        } \
+        \
+        free(old_meta); \
+        free(old_entries); \
+        \
+        return true; \
+    } \
+    \
+    static inline name *name##_init(size_t init_size) { \
+        name *t = (name *)malloc(sizeof(name)); \
+        size_t size = 8; \
+        \
+        if(!t) { \
+            fputs("Cannot allocate a memory for " #name " struct.\n", stderr); \
+            return NULL; \
+        } \
+        \
+        while(size < init_size && size <= SIZE_MAX / 2) { \
+            size *= 2; \
+        } \
+        \
+        t->element_count = 0; \
+        \
+        if(!name##_alloc(t, size)) { \
+            free(t); \
+            return NULL; \
+        } \
+        \
+        return t; \
+    } \
+    \
+    static inline bool name##_set(name *t, KeyT key, ValT value) { \
+        if(!t) { \
+            fputs("Cannot set a value for an unallocated " #name ".\n", stderr); \
+            return false; \
+        } \
+        \
+        size_t index = name##_find(t, key); \
+        \
+        if(index != SIZE_MAX) { \
+            t->entries[index].value = value; \
+            return true; \
+        } \
+        \
+        if((t->element_count + t->tombstone_count + 1) * 10 > t->size * 7) { \
+            /* Mostly tombstones: rebuilding at the same size is enough */ \
+            size_t new_size = (t->element_count + 1) * 10 > t->size * 7 / 2 ? t->size * 2 : t->size; \
+            \
+            if(new_size < t->size || !name##_rehash(t, new_size)) { \
+                fputs(#name " resize failed.\n", stderr); \
+                return false; \
+            } \
+        } \
+        \
+        uint64_t mixed = name##_mix(key); \
+        \
+        index = name##_home(t, mixed); \
+        \
+        while(t->meta[index] & 0x80) { \
+            index = (index + 1) & (t->size - 1); \
+        } \
+        \
+        if(t->meta[index] == HT_DEFINE_TOMBSTONE) { \
+            t->tombstone_count--; \
+        } \
+        \
+        t->meta[index] = name##_tag(mixed); \
+        t->entries[index].key = key; \
+        t->entries[index].value = value; \
+        t->element_count++; \
+        \
+        return true; \
+    } \
+    \
+    static inline ValT *name##_get(name *t, KeyT key) { \
+        size_t index = t ? name##_find(t, key) : SIZE_MAX; \
+        \
+        return index != SIZE_MAX ? &t->entries[index].value : NULL; \
+    } \
+    \
+    static inline bool name##_try_get(name *t, KeyT key, ValT *out) { \
+        ValT *value = name##_get(t, key); \
+        \
+        if(value && out) { \
+            *out = *value; \
+        } \
+        \
+        return value != NULL; \
+    } \
+    \
+    static inline bool name##_delete(name *t, KeyT key) { \
+        size_t index = t ? name##_find(t, key) : SIZE_MAX; \
+        \
+        if(index == SIZE_MAX) { \
+            return false; \
+        } \
+        \
+        t->meta[index] = HT_DEFINE_TOMBSTONE; \
+        t->element_count--; \
+        t->tombstone_count++; \
+        \
+        return true; \
+    } \
+    \
+    static inline bool name##_has(name *t, KeyT key) { \
+        return t && name##_find(t, key) != SIZE_MAX; \
+    } \
+    \
+    static inline size_t name##_count(name *t) { \
+        return t ? t->element_count : 0; \
+    } \
+    \
+    static inline void name##_free(name **t_ptr) { \
+        if(!t_ptr || !*t_ptr) { \
+            return; \
+        } \
+        \
+        free((*t_ptr)->meta); \
+        free((*t_ptr)->entries); \
+        free(*t_ptr); \
+        *t_ptr = NULL; \
+    }
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef HASH_TABLE_INTERNAL_H
+#define HASH_TABLE_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Helpers shared by the library's translation units; not installed.
+
+// FNV-1a (Fowler-Noll-Vo) Algorithm, full 32-bit result
+static inline uint32_t ht_fnv1a(const char *key) {
+    uint32_t hash_value = 2166136261; // FNV offset basis
+
+    for(size_t i = 0; key[i] != '\0'; i++) {
+        hash_value ^= (unsigned char)key[i];
+        hash_value *= 16777619; // FNV prime
+    }
+
+    return hash_value;
+}
+
+// Minimal perfect hash addressing shared by frozen tables and generated static tables.
+// A key's 64-bit hash picks a bucket; the bucket's pilot moves the key to its position.
+
+static inline uint64_t ht_mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+// 64-bit FNV-1a whose offset basis depends on the seed, so a new seed is a new function
+static inline uint64_t ht_frozen_hash(const char *key, uint64_t seed) {
+    uint64_t hash_value = 14695981039346656037ULL ^ ht_mix64(seed);
+
+    for(size_t i = 0; key[i] != '\0'; i++) {
+        hash_value ^= (unsigned char)key[i];
+        hash_value *= 1099511628211ULL;
+    }
+
+    return ht_mix64(hash_value);
+}
+
+// About 60% of the keys go to the first 30% of the buckets. Their buckets are placed
+// first, while most positions are still free, which keeps pilot searches short.
+static inline size_t ht_frozen_bucket(uint64_t hash_value, size_t bucket_count, size_t dense_buckets) {
+    uint64_t selector = hash_value & 0xffffffff;
+    uint64_t high = hash_value >> 32;
+
+    if(selector < (uint64_t)(0.6 * 4294967296.0) || dense_buckets == bucket_count) {
+        return high % dense_buckets;
+    }
+
+    return dense_buckets + high % (bucket_count - dense_buckets);
+}
+
+static inline size_t ht_frozen_position(uint64_t hash_value, uint16_t pilot, size_t table_size) {
+    return (hash_value ^ ht_mix64(pilot + 0x9e3779b97f4a7c15ULL)) % table_size;
+}
+
+// Hierarchical timer wheel backing per-entry TTLs (hashtimer.c)
+
+#define HT_WHEEL_BITS 6
+#define HT_WHEEL_SLOTS (1 << HT_WHEEL_BITS)
+#define HT_WHEEL_LEVELS 11 // 11 levels of 6 bits cover the whole 64-bit time range
+#define HT_WHEEL_DUE UINT16_MAX
+
+typedef struct HashTimer {
+    struct HashTimer *next;
+    struct HashTimer **pprev; // address of the pointer that points at this timer
+    void *data;
+    uint64_t expires_at;
+    uint16_t where;           // level * HT_WHEEL_SLOTS + bucket, or HT_WHEEL_DUE
+} HashTimer;
+
+typedef struct HashTimerWheel {
+    uint64_t now;   // time the wheel has been advanced to
+    uint64_t clock; // latest time reported by the caller; may run ahead of now
+    size_t pending;
+    HashTimer *due; // timers that have expired but have not been reaped yet
+    uint64_t occupied[HT_WHEEL_LEVELS];
+    HashTimer *buckets[HT_WHEEL_LEVELS][HT_WHEEL_SLOTS];
+} HashTimerWheel;
+
+HashTimerWheel *ht_wheel_create(void);
+void ht_wheel_schedule(HashTimerWheel *wheel, HashTimer *timer);
+void ht_wheel_cancel(HashTimerWheel *wheel, HashTimer *timer);
+size_t ht_wheel_advance(HashTimerWheel *wheel, uint64_t now, size_t budget, void (*expire)(HashTimer *timer, void *ctx), void *ctx);
+
+// Epoch-based reclamation shared by the concurrent tables (hashepoch.c).
+// Readers bracket every access with ht_epoch_enter/ht_epoch_exit, which only write the
+// calling thread's own cache-line sized record. Writers hand memory that readers may
+// still see to ht_epoch_retire, which frees it once every reader that could have seen
+// it has left its read-side section; it queues on the calling thread's record and takes
+// no lock, and destroy callbacks run on whichever thread frees the memory.
+// ht_epoch_reclaim frees whatever is due without waiting; ht_epoch_synchronize waits out
+// a grace period and must not be called from inside a read-side section.
+
+void ht_epoch_enter(void);
+void ht_epoch_exit(void);
+void ht_epoch_retire(void *ptr, void (*destroy)(void *ptr));
+void ht_epoch_reclaim(void);
+void ht_epoch_synchronize(void);
+
+// Parallel task runner for operations over large arrays (hashparallel.c).
+// Calls task once for every worker index in [0, workers) and returns when all calls are done.
+
+typedef void (*HashParallelTask)(void *ctx, unsigned worker, unsigned workers);
+
+unsigned ht_parallel_cpus(void);
+void ht_parallel_run(unsigned workers, HashParallelTask task, void *ctx);
+
+// Page-granular slot array memory (hashpages.c).
+// ht_pages_alloc returns zeroed, untouched anonymous memory, backed by huge pages if
+// huge is set and the system allows it, or NULL. Free it with the same bytes and huge.
+
+#define HT_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// How a table's current slot array was allocated, so that it is freed the same way
+#define HT_MEMORY_HEAP 0
+#define HT_MEMORY_MAPPED 1
+#define HT_MEMORY_HUGE 2
+
+void *ht_pages_alloc(size_t bytes, bool huge);
+void ht_pages_free(void *ptr, size_t bytes, bool huge);
+
+// NUMA placement and topology (hashnuma.c).
+// ht_numa_place applies an HT_NUMA_* policy to untouched mapped memory.
+
+unsigned ht_numa_node_count(void);
+unsigned ht_numa_current_node(void);
+bool ht_numa_place(void *ptr, size_t bytes, int policy, unsigned node);
+
+// Small blocks carved from memory bound to one node (hashnuma.c). Not synchronized;
+// blocks must be freed with the size they were allocated with.
+typedef struct HashNodeArena HashNodeArena;
+
+HashNodeArena *ht_node_arena_create(unsigned node);
+void *ht_node_arena_alloc(HashNodeArena *arena, size_t bytes);
+void ht_node_arena_free(HashNodeArena *arena, void *ptr, size_t bytes);
+void ht_node_arena_destroy(HashNodeArena *arena);
+
+// Hands a heap block holding keys or values to the table, which frees it in ht_free (hashtable.c)
+struct HashTable;
+
+bool ht_own_memory(struct HashTable *ht, void *ptr);
+
+// Grows the table until count entries fit, so that inserting up to that many cannot resize it
+bool ht_reserve(struct HashTable *ht, size_t count);
+
+// The key pointer the table stored for key, including an expired one, or NULL if it is absent
+const char *ht_stored_key(struct HashTable *ht, const char *key);
+
+// Binary table file format (hashsnapshot.c, hashmapped.c).
+// All offsets are in bytes and all integers are in the byte order of the machine that
+// wrote the file, which byte_order records. The file is laid out as:
+//   HashFileHeader
+//   uint64_t slots[size]      0 = empty, HT_FILE_TOMBSTONE, otherwise entry index + 1
+//   HashFileEntry entries[count]
+//   blob                      keys (NUL-terminated) and values, values and the blob's end 16-byte aligned
+//   HashFileTrailer           checksum of everything before it
+// Slots keep their indices, so a loaded table needs no hashing or probing.
+
+#define HT_FILE_MAGIC "HTSNAP\r\n"
+#define HT_FILE_TRAILER_MAGIC "HTSEND\r\n"
+#define HT_FILE_VERSION 1
+#define HT_FILE_BYTE_ORDER 0x01020304u
+#define HT_FILE_ALIGN 16
+#define HT_FILE_TOMBSTONE UINT64_MAX
+#define HT_FILE_NULL_VALUE UINT64_MAX
+#define HT_FILE_ENTRY_TTL 1u
+
+typedef struct HashFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t size;           // slots
+    uint64_t count;          // entries
+    uint64_t slots_offset;
+    uint64_t entries_offset;
+    uint64_t blob_offset;    // HT_FILE_ALIGN aligned
+    uint64_t blob_size;
+} HashFileHeader;
+
+typedef struct HashFileEntry {
+    uint64_t key_offset;     // from the start of the blob
+    uint64_t value_offset;   // from the start of the blob, or HT_FILE_NULL_VALUE
+    uint64_t value_length;
+    uint64_t expires_at;     // with HT_FILE_ENTRY_TTL
+    uint32_t key_length;
+    uint32_t hash;           // full FNV-1a hash of the key
+    uint32_t flags;
+    uint32_t reserved;
+} HashFileEntry;
+
+typedef struct {
+    uint64_t checksum;
+    char magic[8];
+} HashFileTrailer;
+
+// FNV-1a over 64-bit words, so that checking a large file runs at memory speed.
+// Data may be fed in pieces as long as every piece but the last is a multiple of 8 bytes.
+static inline uint64_t ht_file_checksum(uint64_t checksum, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    size_t i = 0;
+
+    for(; i + 8 <= length; i += 8) {
+        uint64_t word;
+
+        memcpy(&word, bytes + i, 8);
+        checksum = (checksum ^ word) * 1099511628211ULL;
+    }
+
+    for(; i < length; i++) {
+        checksum = (checksum ^ bytes[i]) * 1099511628211ULL;
+    }
+
+    return checksum;
+}
+
+#define HT_FILE_CHECKSUM_SEED 14695981039346656037ULL
+
+// Whether [offset, offset + length) lies inside [0, limit), without overflowing
+static inline bool ht_file_in_bounds(uint64_t offset, uint64_t length, uint64_t limit) {
+    return offset <= limit && length <= limit - offset;
+}
+
+// Checks the header, section bounds and trailer of a table file image, and its checksum
+// if asked to. Returns the header, or NULL after reporting the problem.
+const HashFileHeader *ht_file_validate(const void *data, size_t length, bool checksum);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+    Hierarchical Timer Wheel
+    
+    Description:
+    Tracks the expiry times of TTL entries so that they can be reaped in amortized O(1)
+    instead of by scanning the whole slot array. Times are opaque 64-bit values in
+    whatever unit the caller uses (e.g. milliseconds).
+
+    The wheel has HT_WHEEL_LEVELS levels of HT_WHEEL_SLOTS buckets. A timer is filed
+    under the level of the highest 6-bit digit in which its expiry time differs from
+    the wheel's current time, in the bucket named by that digit. Hence every occupied
+    bucket lies strictly ahead of the current time's digit on its level, and the
+    lowest occupied level always holds the earliest timers. Advancing the wheel jumps
+    straight to the next occupied bucket with the help of a per-level occupancy
+    bitmap, and re-files (cascades) its timers one level down. Timers that reach their
+    expiry time move to the due list, where they wait to be reaped under the caller's
+    budget. Each timer cascades at most once per level.
+*/
+
+#include <stdlib.h>
+
+#include "hashtable_internal.h"
+
+static void wheel_push(HashTimer **head, HashTimer *timer) {
+    timer->next = *head;
+    timer->pprev = head;
+
+    if(*head) {
+        (*head)->pprev = &timer->next;
+    }
+
+    *head = timer;
+}
+
+HashTimerWheel *ht_wheel_create(void) {
+    return calloc(1, sizeof(HashTimerWheel));
+}
+
+void ht_wheel_schedule(HashTimerWheel *wheel, HashTimer *timer) {
+    wheel->pending++;
+
+    if(timer->expires_at <= wheel->now) {
+        timer->where = HT_WHEEL_DUE;
+        wheel_push(&wheel->due, timer);
+
+        return;
+    }
+
+    uint64_t diff = timer->expires_at ^ wheel->now;
+    unsigned level = (63 - __builtin_clzll(diff)) / HT_WHEEL_BITS;
+    unsigned bucket = (timer->expires_at >> (level * HT_WHEEL_BITS)) & (HT_WHEEL_SLOTS - 1);
+
+    timer->where = (uint16_t)(level * HT_WHEEL_SLOTS + bucket);
+    wheel_push(&wheel->buckets[level][bucket], timer);
+    wheel->occupied[level] |= 1ULL << bucket;
+}
+
+void ht_wheel_cancel(HashTimerWheel *wheel, HashTimer *timer) {
+    *timer->pprev = timer->next;
+
+    if(timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+
+    if(timer->where != HT_WHEEL_DUE) {
+        unsigned level = timer->where / HT_WHEEL_SLOTS;
+        unsigned bucket = timer->where % HT_WHEEL_SLOTS;
+
+        if(!wheel->buckets[level][bucket]) {
+            wheel->occupied[level] &= ~(1ULL << bucket);
+        }
+    }
+
+    wheel->pending--;
+}
+
+// Finds the earliest occupied bucket; returns false if the wheel holds no timers
+static bool wheel_next_bucket(HashTimerWheel *wheel, unsigned *level_out, unsigned *bucket_out) {
+    for(unsigned level = 0; level < HT_WHEEL_LEVELS; level++) {
+        unsigned digit = (wheel->now >> (level * HT_WHEEL_BITS)) & (HT_WHEEL_SLOTS - 1);
+        uint64_t ahead = digit == HT_WHEEL_SLOTS - 1 ? 0 : wheel->occupied[level] & (~0ULL << (digit + 1));
+
+        if(ahead) {
+            *level_out = level;
+            *bucket_out = (unsigned)__builtin_ctzll(ahead);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t ht_wheel_advance(HashTimerWheel *wheel, uint64_t now, size_t budget, void (*expire)(HashTimer *timer, void *ctx), void *ctx) {
+    size_t expired = 0;
+
+    if(now > wheel->clock) {
+        wheel->clock = now;
+    }
+
+    for(;;) {
+        while(wheel->due && expired < budget) {
+            HashTimer *timer = wheel->due;
+
+            ht_wheel_cancel(wheel, timer);
+            expire(timer, ctx);
+            expired++;
+        }
+
+        if(expired >= budget) {
+            break;
+        }
+
+        unsigned level, bucket;
+
+        if(!wheel_next_bucket(wheel, &level, &bucket)) {
+            wheel->now = wheel->now > now ? wheel->now : now;
+            break;
+        }
+
+        unsigned shift = (level + 1) * HT_WHEEL_BITS;
+        uint64_t high = shift >= 64 ? 0 : wheel->now >> shift << shift;
+        uint64_t start = high | ((uint64_t)bucket << (level * HT_WHEEL_BITS));
+
+        if(start > now) {
+            wheel->now = wheel->now > now ? wheel->now : now;
+            break;
+        }
+
+        // Cascade the bucket: every timer in it now lands on a lower level or the due list
+        HashTimer *timer = wheel->buckets[level][bucket];
+
+        wheel->now = start;
+        wheel->buckets[level][bucket] = NULL;
+        wheel->occupied[level] &= ~(1ULL << bucket);
+
+        while(timer) {
+            HashTimer *next = timer->next;
+
+            wheel->pending--;
+            ht_wheel_schedule(wheel, timer);
+            timer = next;
+        }
+    }
+
+    return expired;
+}
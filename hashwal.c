@@ -0,0 +1,501 @@
+/*
+    Write-Ahead Log
+    
+    Description:
+    Makes a hash table's mutations durable. `ht_wal_set` and `ht_wal_delete` append a
+    record to the log and then apply the change to the table; lookups use the table
+    directly and never touch the log. On startup, `ht_wal_recover` loads the latest
+    snapshot and replays the log on top of it.
+
+    Records are appended to an in-memory buffer and written out in batches, so the
+    mutations of one batch share a single `write` and, depending on the sync policy, a
+    single `fdatasync` (group commit):
+    - HT_WAL_SYNC_NEVER: batches are written but never synced; a crash of the process
+      loses nothing, a crash of the machine may lose what the OS had not written back.
+    - HT_WAL_SYNC_COMMIT: `ht_wal_commit` writes and syncs the pending batch; every
+      mutation before it survives a crash once it returns.
+    - HT_WAL_SYNC_ALWAYS: every mutation is synced before it returns.
+    With a non-zero interval, a background thread commits the pending batch every
+    `interval_ms` milliseconds. There are two buffers: while one batch is written and
+    synced, the writer keeps appending to the other, so a sync never blocks a
+    mutation unless the second buffer fills up as well.
+
+    Every record carries a checksum. Replay stops at the first record that is
+    incomplete or damaged, which is where a crash in the middle of a write leaves the
+    log; opening the log for appending cuts that tail off.
+
+    `ht_wal_checkpoint` saves a snapshot and empties the log, bounding both its size
+    and recovery time. Replaying sets and deletes is idempotent, so a crash between
+    the two steps only replays records that the snapshot already contains.
+
+    As with snapshots, values are copied as the number of bytes the value size
+    callback reports (NUL-terminated strings if it is NULL), and a recovered table owns
+    the keys and values it was rebuilt from. Like the table, a log has a single writer:
+    mutations and checkpoints need the same external lock as the table, while the
+    background flusher synchronizes with them internally.
+
+    Functions:
+    - Opening and closing (`ht_wal_open`, `ht_wal_close`); closing commits what is pending.
+    - Logged mutations (`ht_wal_set`, `ht_wal_delete`) and group commit (`ht_wal_commit`).
+    - Checkpointing (`ht_wal_checkpoint`) and recovery (`ht_wal_recover`).
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hashtable_internal.h"
+#include "hashwal.h"
+
+#define HT_WAL_BUFFER (1 << 20)
+#define HT_WAL_MAGIC "HTWAL\r\n"
+#define HT_WAL_VERSION 1
+#define HT_WAL_SET 1
+#define HT_WAL_DELETE 2
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+} HashWalHeader;
+
+// Followed by the key and its NUL, padding to 8 bytes, the value and padding to 8 bytes
+typedef struct {
+    uint64_t checksum;     // of everything after this field, padding included
+    uint32_t op;
+    uint32_t key_length;
+    uint64_t value_length; // HT_FILE_NULL_VALUE for a NULL value
+} HashWalRecord;
+
+static size_t pad8(size_t length) {
+    return (length + 7) & ~(size_t)7;
+}
+
+static size_t string_size(const void *value) {
+    return strlen(value) + 1;
+}
+
+static bool write_all(int fd, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+
+    while(length > 0) {
+        ssize_t written = write(fd, bytes, length);
+
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        else if(written <= 0) {
+            return false;
+        }
+
+        bytes += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+// Writes the pending batch and, if asked and the policy syncs at all, makes it durable
+static bool wal_flush(HashWal *wal, bool sync) {
+    pthread_mutex_lock(&wal->flush_lock);
+    pthread_mutex_lock(&wal->lock);
+
+    unsigned char *batch = wal->buffers[wal->active];
+    size_t length = wal->used;
+
+    wal->active ^= 1;
+    wal->used = 0;
+    pthread_mutex_unlock(&wal->lock);
+
+    bool ok = !__atomic_load_n(&wal->failed, __ATOMIC_RELAXED) && write_all(wal->fd, batch, length);
+
+    if(ok && sync && wal->sync != HT_WAL_SYNC_NEVER) {
+        ok = fdatasync(wal->fd) == 0;
+    }
+
+    if(!ok && !__atomic_load_n(&wal->failed, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&wal->failed, true, __ATOMIC_RELAXED);
+        fprintf(stderr, "Write-ahead log write failed: %s.\n", strerror(errno));
+    }
+
+    pthread_mutex_unlock(&wal->flush_lock);
+
+    return ok;
+}
+
+static void encode_record(unsigned char *dest, uint32_t op, const char *key, size_t key_length, const void *value, size_t value_length) {
+    HashWalRecord record = {0, op, (uint32_t)key_length, value ? value_length : HT_FILE_NULL_VALUE};
+    size_t value_offset = pad8(sizeof(record) + key_length + 1);
+    size_t end = pad8(value_offset + (value ? value_length : 0));
+
+    memset(dest, 0, end);
+    memcpy(dest, &record, sizeof(record));
+    memcpy(dest + sizeof(record), key, key_length + 1);
+
+    if(value) {
+        memcpy(dest + value_offset, value, value_length);
+    }
+
+    record.checksum = ht_file_checksum(HT_FILE_CHECKSUM_SEED, dest + sizeof(uint64_t), end - sizeof(uint64_t));
+    memcpy(dest, &record.checksum, sizeof(uint64_t));
+}
+
+static bool wal_append(HashWal *wal, uint32_t op, const char *key, const void *value) {
+    size_t key_length = strlen(key);
+    size_t value_length = value ? wal->value_size(value) : 0;
+    size_t length = pad8(pad8(sizeof(HashWalRecord) + key_length + 1) + value_length);
+
+    if(length > HT_WAL_BUFFER) {
+        // Too big for a batch: write out what is pending, then the record on its own
+        unsigned char *record = malloc(length);
+
+        if(!record) {
+            fputs("Cannot allocate a memory for write-ahead log record.\n", stderr);
+            return false;
+        }
+
+        encode_record(record, op, key, key_length, value, value_length);
+
+        bool ok = wal_flush(wal, false);
+
+        pthread_mutex_lock(&wal->flush_lock);
+        ok = ok && write_all(wal->fd, record, length);
+        pthread_mutex_unlock(&wal->flush_lock);
+        free(record);
+
+        return ok && (wal->sync != HT_WAL_SYNC_ALWAYS || wal_flush(wal, true));
+    }
+
+    pthread_mutex_lock(&wal->lock);
+
+    while(wal->used + length > HT_WAL_BUFFER) {
+        pthread_mutex_unlock(&wal->lock);
+
+        if(!wal_flush(wal, false)) {
+            return false;
+        }
+
+        pthread_mutex_lock(&wal->lock);
+    }
+
+    encode_record(wal->buffers[wal->active] + wal->used, op, key, key_length, value, value_length);
+    wal->used += length;
+    pthread_mutex_unlock(&wal->lock);
+
+    return !__atomic_load_n(&wal->failed, __ATOMIC_RELAXED) && (wal->sync != HT_WAL_SYNC_ALWAYS || wal_flush(wal, true));
+}
+
+bool ht_wal_set(HashWal *wal, HashTable *ht, const char *key, void *value) {
+    if(!wal || !ht) {
+        fputs("Cannot log a mutation without a log and a hash table.\n", stderr);
+        return false;
+    }
+    else if(!key || *key == '\0') {
+        fputs("Key cannot be NULL or an empty string.\n", stderr);
+        return false;
+    }
+
+    return wal_append(wal, HT_WAL_SET, key, value) && ht_set(ht, key, value);
+}
+
+bool ht_wal_delete(HashWal *wal, HashTable *ht, const char *key) {
+    if(!wal || !ht) {
+        fputs("Cannot log a mutation without a log and a hash table.\n", stderr);
+        return false;
+    }
+    else if(!key || *key == '\0') {
+        fputs("Key cannot be NULL or an empty string.\n", stderr);
+        return false;
+    }
+
+    if(!wal_append(wal, HT_WAL_DELETE, key, NULL)) {
+        return false;
+    }
+
+    ht_delete(ht, key);
+
+    return true;
+}
+
+bool ht_wal_commit(HashWal *wal) {
+    return wal && wal_flush(wal, true);
+}
+
+bool ht_wal_checkpoint(HashWal *wal, HashTable *ht, const char *snapshot_path) {
+    if(!wal || !ht || !ht_wal_commit(wal) || !ht_save_values(ht, snapshot_path, wal->value_size)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&wal->flush_lock);
+
+    bool ok = ftruncate(wal->fd, sizeof(HashWalHeader)) == 0
+        && lseek(wal->fd, 0, SEEK_END) >= 0
+        && fdatasync(wal->fd) == 0;
+
+    pthread_mutex_unlock(&wal->flush_lock);
+
+    if(!ok) {
+        fprintf(stderr, "Cannot truncate write-ahead log: %s.\n", strerror(errno));
+    }
+
+    return ok;
+}
+
+// Walks the valid records of a log image and applies them to ht if it is not NULL.
+// Returns the length of the valid prefix, or 0 if the image is not a log.
+static size_t replay(unsigned char *data, size_t length, HashTable *ht) {
+    const HashWalHeader *header = (const HashWalHeader *)data;
+
+    if(length < sizeof(HashWalHeader)
+        || memcmp(header->magic, HT_WAL_MAGIC, 8) != 0
+        || header->version != HT_WAL_VERSION
+        || header->byte_order != HT_FILE_BYTE_ORDER) {
+        return 0;
+    }
+
+    size_t offset = sizeof(HashWalHeader);
+
+    while(length - offset >= sizeof(HashWalRecord)) {
+        HashWalRecord record;
+
+        memcpy(&record, data + offset, sizeof(record));
+
+        size_t available = length - offset;
+        bool has_value = record.value_length != HT_FILE_NULL_VALUE;
+
+        if(record.key_length == 0
+            || record.key_length > available
+            || (has_value && record.value_length > available)) {
+            break;
+        }
+
+        size_t value_offset = pad8(sizeof(record) + record.key_length + 1);
+        size_t end = pad8(value_offset + (has_value ? record.value_length : 0));
+        char *key = (char *)data + offset + sizeof(record);
+
+        if(end > available
+            || ht_file_checksum(HT_FILE_CHECKSUM_SEED, data + offset + sizeof(uint64_t), end - sizeof(uint64_t)) != record.checksum
+            || key[record.key_length] != '\0') {
+            break;
+        }
+
+        if(ht && record.op == HT_WAL_SET) {
+            if(!ht_set(ht, key, has_value ? data + offset + value_offset : NULL)) {
+                fputs("Write-ahead log replay stopped: cannot apply a record.\n", stderr);
+                break;
+            }
+        }
+        else if(ht && record.op == HT_WAL_DELETE) {
+            ht_delete(ht, key);
+        }
+
+        offset += end;
+    }
+
+    return offset;
+}
+
+static bool read_log(int fd, unsigned char **data, size_t *length) {
+    struct stat st;
+
+    if(fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    *length = st.st_size;
+    *data = malloc(*length ? *length : 1);
+
+    size_t done = 0;
+
+    while(*data && done < *length) {
+        ssize_t n = pread(fd, *data + done, *length - done, done);
+
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        else if(n <= 0) {
+            break;
+        }
+
+        done += n;
+    }
+
+    if(!*data || done < *length) {
+        free(*data);
+        return false;
+    }
+
+    return true;
+}
+
+HashTable *ht_wal_recover(const char *snapshot_path, const char *log_path) {
+    HashTable *ht = snapshot_path && access(snapshot_path, F_OK) == 0 ? ht_load(snapshot_path) : ht_init(16);
+
+    if(!ht || !log_path) {
+        return ht;
+    }
+
+    int fd = open(log_path, O_RDONLY);
+
+    if(fd < 0 && errno == ENOENT) {
+        return ht;
+    }
+
+    unsigned char *data = NULL;
+    size_t length = 0;
+
+    if(fd < 0 || !read_log(fd, &data, &length) || (length > 0 && replay(data, length, NULL) == 0)) {
+        fprintf(stderr, "Cannot recover from write-ahead log '%s'.\n", log_path);
+        ht_free(&ht);
+    }
+    // Keys and values of replayed records stay in the log image, which the table keeps
+    else if(length > 0 && !ht_own_memory(ht, data)) {
+        ht_free(&ht);
+    }
+    else if(length > 0) {
+        replay(data, length, ht);
+        data = NULL;
+    }
+
+    if(fd >= 0) {
+        close(fd);
+    }
+
+    free(data);
+
+    return ht;
+}
+
+static void *run_flusher(void *arg) {
+    HashWal *wal = arg;
+
+    pthread_mutex_lock(&wal->lock);
+
+    while(!wal->stopping) {
+        struct timespec deadline;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wal->interval_ms / 1000;
+        deadline.tv_nsec += (long)(wal->interval_ms % 1000) * 1000000;
+
+        if(deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait(&wal->wake, &wal->lock, &deadline);
+
+        if(wal->used > 0) {
+            pthread_mutex_unlock(&wal->lock);
+            wal_flush(wal, true);
+            pthread_mutex_lock(&wal->lock);
+        }
+    }
+
+    pthread_mutex_unlock(&wal->lock);
+
+    return NULL;
+}
+
+void ht_wal_close(HashWal **wal_ptr) {
+    if(!wal_ptr || !*wal_ptr) {
+        return;
+    }
+
+    HashWal *wal = *wal_ptr;
+
+    if(wal->interval_ms > 0) {
+        pthread_mutex_lock(&wal->lock);
+        wal->stopping = true;
+        pthread_cond_signal(&wal->wake);
+        pthread_mutex_unlock(&wal->lock);
+        pthread_join(wal->flusher, NULL);
+    }
+
+    wal_flush(wal, true);
+    close(wal->fd);
+    pthread_mutex_destroy(&wal->lock);
+    pthread_mutex_destroy(&wal->flush_lock);
+    pthread_cond_destroy(&wal->wake);
+    free(wal->buffers[0]);
+    free(wal->buffers[1]);
+    free(wal);
+    *wal_ptr = NULL;
+}
+
+// Positions fd for appending after the last valid record, writing a header to a new log
+static bool prepare_log(int fd) {
+    unsigned char *data;
+    size_t length;
+
+    if(!read_log(fd, &data, &length)) {
+        return false;
+    }
+
+    size_t valid = length > 0 ? replay(data, length, NULL) : 0;
+
+    free(data);
+
+    if(length > 0 && valid == 0) {
+        fputs("Not a write-ahead log.\n", stderr);
+        return false;
+    }
+    else if(length == 0) {
+        HashWalHeader header = {HT_WAL_MAGIC, HT_WAL_VERSION, HT_FILE_BYTE_ORDER};
+
+        return write_all(fd, &header, sizeof(header)) && fdatasync(fd) == 0;
+    }
+
+    return (valid == length || ftruncate(fd, valid) == 0) && lseek(fd, valid, SEEK_SET) >= 0;
+}
+
+HashWal *ht_wal_open(const char *path, HashWalSync sync, unsigned interval_ms, HashValueSize value_size) {
+    if(!path) {
+        fputs("Write-ahead log path cannot be NULL.\n", stderr);
+        return NULL;
+    }
+
+    HashWal *wal = calloc(1, sizeof(HashWal));
+
+    if(!wal) {
+        fputs("Cannot allocate a memory for write-ahead log.\n", stderr);
+        return NULL;
+    }
+
+    wal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    wal->sync = sync;
+    wal->value_size = value_size ? value_size : string_size;
+    wal->interval_ms = interval_ms;
+    wal->buffers[0] = malloc(HT_WAL_BUFFER);
+    wal->buffers[1] = malloc(HT_WAL_BUFFER);
+
+    if(wal->fd < 0 || !wal->buffers[0] || !wal->buffers[1] || !prepare_log(wal->fd)) {
+        fprintf(stderr, "Cannot open write-ahead log '%s'.\n", path);
+
+        if(wal->fd >= 0) {
+            close(wal->fd);
+        }
+
+        free(wal->buffers[0]);
+        free(wal->buffers[1]);
+        free(wal);
+
+        return NULL;
+    }
+
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_mutex_init(&wal->flush_lock, NULL);
+    pthread_cond_init(&wal->wake, NULL);
+
+    if(interval_ms > 0 && pthread_create(&wal->flusher, NULL, run_flusher, wal) != 0) {
+        fputs("Cannot start write-ahead log flusher; batches are committed explicitly.\n", stderr);
+        wal->interval_ms = 0;
+    }
+
+    return wal;
+}
@@ -0,0 +1,41 @@
+#ifndef HASH_WAL_H
+#define HASH_WAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hashsnapshot.h"
+#include "hashtable.h"
+
+typedef enum {
+    HT_WAL_SYNC_NEVER,  // records are written in batches and left to the OS to persist
+    HT_WAL_SYNC_COMMIT, // a batch is synced when it is committed (group commit)
+    HT_WAL_SYNC_ALWAYS  // every mutation is synced before it returns
+} HashWalSync;
+
+typedef struct HashWal {
+    int fd;
+    HashWalSync sync;
+    HashValueSize value_size;
+    pthread_mutex_t lock;       // guards the active buffer
+    pthread_mutex_t flush_lock; // one batch is written to the file at a time
+    unsigned char *buffers[2];  // records are appended to one while the other is written
+    unsigned active;
+    size_t used;
+    bool failed;                // a write to the log failed; later commits report it
+    unsigned interval_ms;       // commit period of the background flusher, 0 for none
+    bool stopping;
+    pthread_cond_t wake;
+    pthread_t flusher;
+} HashWal;
+
+bool ht_wal_set(HashWal *wal, HashTable *ht, const char *key, void *value);
+bool ht_wal_delete(HashWal *wal, HashTable *ht, const char *key);
+bool ht_wal_commit(HashWal *wal);
+bool ht_wal_checkpoint(HashWal *wal, HashTable *ht, const char *snapshot_path);
+HashTable *ht_wal_recover(const char *snapshot_path, const char *log_path);
+void ht_wal_close(HashWal **wal_ptr);
+HashWal *ht_wal_open(const char *path, HashWalSync sync, unsigned interval_ms, HashValueSize value_size);
+
+#endif
@@ -0,0 +1,500 @@
+/*
+    Benchmark Suite
+
+    Description:
+    Measures the hash table on a fixed set of workloads and reports throughput,
+    per-operation latency percentiles and memory per entry, as a table on standard
+    output and optionally as JSON, so that results can be compared between commits.
+
+    Workloads:
+    - insert_empty / insert_reserved: inserting every key into a table that starts
+      empty and resizes as it grows, or that is sized for all keys up front.
+    - lookup_hit / lookup_miss: lookups of present keys in random order, and of keys
+      that were never inserted.
+    - delete_churn: alternately deleting a present key and inserting a new one, so
+      the count stays constant while tombstones accumulate.
+    - mixed_r90 / mixed_r50: random reads and writes at 90% and 50% reads over a table
+      holding half of the key set, so reads hit half of the time and writes are both
+      inserts and updates.
+    - lookup_hit/len=N: lookups with keys of N characters (16 elsewhere).
+    - lookup_hit/load=F, lookup_miss/load=F: lookups in a table of fixed size filled
+      to load factor F, up to just below the 0.7 resize threshold.
+
+    Throughput is the median of several untimed-per-operation runs. Latencies come
+    from one more run that times each operation, minus the cost of reading the clock.
+    Memory per entry is the heap growth of the table divided by its entries; keys are
+    owned by the caller and not included.
+
+    Usage:
+        htbench [-n count] [-r repeat] [-s seed] [-w filter] [-o report.json]
+
+    `count` is the number of keys per workload (default 1000000), `repeat` the number
+    of throughput runs (default 3) and `filter` runs only workloads whose name
+    contains it. Results only depend on the seed (default 1) and the machine.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hashtable.h"
+#include "htbench.h"
+
+#define HT_BENCH_KEY_LENGTH 16
+#define HT_BENCH_TABLE_LOAD 0.7
+
+typedef struct {
+    size_t count;
+    double param;           // read ratio or load factor, depending on the workload
+    uint64_t seed;
+    const BenchKeys *hits;  // keys to insert
+    const BenchKeys *misses; // disjoint keys that are never found
+    const size_t *order;    // random permutation of 0..count-1
+} BenchSpec;
+
+typedef struct {
+    uint32_t *samples;      // per-operation latencies in ns, NULL when not measuring them
+    uint64_t overhead;
+    uint64_t start;
+    uint64_t elapsed;
+    size_t ops;
+    size_t heap_bytes;      // heap growth of the table, SIZE_MAX if unknown
+    size_t entries;
+    double load_factor;     // of the table when the workload finished
+    uintptr_t sink;         // keeps lookups from being optimized away
+} BenchRun;
+
+typedef struct {
+    const char *name;
+    bool (*run)(const BenchSpec *spec, BenchRun *run);
+    size_t key_length;
+    double param;
+    size_t max_ops_per_key;
+} BenchWorkload;
+
+typedef struct {
+    const char *name;
+    size_t key_length;
+    size_t ops;
+    double ops_per_sec;
+    BenchLatency latency;
+    double bytes_per_entry; // negative if unknown
+    double load_factor;
+} BenchResult;
+
+static void usage(void) {
+    fputs("Usage: htbench [-n count] [-r repeat] [-s seed] [-w filter] [-o report.json]\n", stderr);
+}
+
+static void bench_begin(BenchRun *run) {
+    run->start = bench_now_ns();
+}
+
+static void bench_end(BenchRun *run, HashTable *ht, size_t heap_before) {
+    size_t heap_after = bench_heap_bytes();
+
+    run->elapsed = bench_now_ns() - run->start;
+    run->entries = ht_count(ht);
+    run->load_factor = (double)ht_count(ht) / (double)ht_size(ht);
+    run->heap_bytes = heap_before == SIZE_MAX || heap_after == SIZE_MAX ? SIZE_MAX : heap_after - heap_before;
+}
+
+// Table holding the first n keys, sized so that it does not resize while filling
+static HashTable *filled_table(const BenchSpec *spec, size_t n, size_t size) {
+    HashTable *ht = ht_init(size ? size : (size_t)(n / HT_BENCH_TABLE_LOAD) + 1);
+
+    if(!ht) {
+        return NULL;
+    }
+
+    for(size_t i = 0; i < n; i++) {
+        if(!ht_set(ht, spec->hits->keys[i], spec->hits->keys[i])) {
+            ht_free(&ht);
+            return NULL;
+        }
+    }
+
+    return ht;
+}
+
+static bool run_insert(const BenchSpec *spec, BenchRun *run, size_t init_size) {
+    size_t heap_before = bench_heap_bytes();
+    HashTable *ht = ht_init(init_size);
+    bool ok = true;
+
+    if(!ht) {
+        return false;
+    }
+
+    bench_begin(run);
+
+    for(size_t i = 0; i < spec->count && ok; i++) {
+        char *key = spec->hits->keys[spec->order[i]];
+
+        BENCH_OP(run, ok = ht_set(ht, key, key));
+    }
+
+    bench_end(run, ht, heap_before);
+    ht_free(&ht);
+
+    return ok;
+}
+
+static bool wl_insert_empty(const BenchSpec *spec, BenchRun *run) {
+    return run_insert(spec, run, 0);
+}
+
+static bool wl_insert_reserved(const BenchSpec *spec, BenchRun *run) {
+    return run_insert(spec, run, (size_t)(spec->count / HT_BENCH_TABLE_LOAD) + 1);
+}
+
+static bool run_lookup(const BenchSpec *spec, BenchRun *run, const BenchKeys *keys, size_t fill, size_t size) {
+    size_t heap_before = bench_heap_bytes();
+    HashTable *ht = filled_table(spec, fill, size);
+    void *value = NULL;
+
+    if(!ht) {
+        return false;
+    }
+
+    bench_begin(run);
+
+    for(size_t i = 0; i < spec->count; i++) {
+        // Only the first fill keys are present; spread the lookups over them
+        const char *key = keys->keys[spec->order[i] % fill];
+
+        BENCH_OP(run, run->sink += ht_try_get(ht, key, &value) + (uintptr_t)value);
+    }
+
+    bench_end(run, ht, heap_before);
+    ht_free(&ht);
+
+    return true;
+}
+
+static bool wl_lookup_hit(const BenchSpec *spec, BenchRun *run) {
+    return run_lookup(spec, run, spec->hits, spec->count, 0);
+}
+
+static bool wl_lookup_miss(const BenchSpec *spec, BenchRun *run) {
+    return run_lookup(spec, run, spec->misses, spec->count, 0);
+}
+
+// The table has one size for every load factor, so the sweep varies only the load
+static size_t sweep_size(const BenchSpec *spec) {
+    return (size_t)(spec->count / HT_BENCH_TABLE_LOAD) + 1;
+}
+
+static size_t sweep_fill(const BenchSpec *spec) {
+    size_t fill = (size_t)(sweep_size(spec) * spec->param);
+
+    return fill ? fill : 1;
+}
+
+static bool wl_lookup_hit_load(const BenchSpec *spec, BenchRun *run) {
+    return run_lookup(spec, run, spec->hits, sweep_fill(spec), sweep_size(spec));
+}
+
+static bool wl_lookup_miss_load(const BenchSpec *spec, BenchRun *run) {
+    return run_lookup(spec, run, spec->misses, sweep_fill(spec), sweep_size(spec));
+}
+
+static bool wl_delete_churn(const BenchSpec *spec, BenchRun *run) {
+    size_t heap_before = bench_heap_bytes();
+    HashTable *ht = filled_table(spec, spec->count, 0);
+    bool ok = true;
+
+    if(!ht) {
+        return false;
+    }
+
+    bench_begin(run);
+
+    for(size_t i = 0; i < spec->count && ok; i++) {
+        char *key = spec->misses->keys[i];
+
+        BENCH_OP(run, ht_delete(ht, spec->hits->keys[spec->order[i]]));
+        BENCH_OP(run, ok = ht_set(ht, key, key));
+    }
+
+    bench_end(run, ht, heap_before);
+    ht_free(&ht);
+
+    return ok;
+}
+
+static bool wl_mixed(const BenchSpec *spec, BenchRun *run) {
+    size_t heap_before = bench_heap_bytes();
+    HashTable *ht = filled_table(spec, spec->count / 2, 0);
+    uint64_t state = spec->seed;
+    uint64_t read_threshold = (uint64_t)(spec->param * (double)UINT32_MAX);
+    void *value = NULL;
+    bool ok = true;
+
+    if(!ht) {
+        return false;
+    }
+
+    bench_begin(run);
+
+    for(size_t i = 0; i < spec->count && ok; i++) {
+        uint64_t r = bench_random(&state);
+        char *key = spec->hits->keys[(r >> 32) % spec->count];
+
+        if((r & UINT32_MAX) < read_threshold) {
+            BENCH_OP(run, run->sink += ht_try_get(ht, key, &value) + (uintptr_t)value);
+        }
+        else {
+            BENCH_OP(run, ok = ht_set(ht, key, key));
+        }
+    }
+
+    bench_end(run, ht, heap_before);
+    ht_free(&ht);
+
+    return ok;
+}
+
+static const BenchWorkload workloads[] = {
+    {"insert_empty", wl_insert_empty, HT_BENCH_KEY_LENGTH, 0, 1},
+    {"insert_reserved", wl_insert_reserved, HT_BENCH_KEY_LENGTH, 0, 1},
+    {"lookup_hit", wl_lookup_hit, HT_BENCH_KEY_LENGTH, 0, 1},
+    {"lookup_miss", wl_lookup_miss, HT_BENCH_KEY_LENGTH, 0, 1},
+    {"delete_churn", wl_delete_churn, HT_BENCH_KEY_LENGTH, 0, 2},
+    {"mixed_r90", wl_mixed, HT_BENCH_KEY_LENGTH, 0.9, 1},
+    {"mixed_r50", wl_mixed, HT_BENCH_KEY_LENGTH, 0.5, 1},
+    {"lookup_hit/len=8", wl_lookup_hit, 8, 0, 1},
+    {"lookup_hit/len=32", wl_lookup_hit, 32, 0, 1},
+    {"lookup_hit/len=64", wl_lookup_hit, 64, 0, 1},
+    {"lookup_hit/len=128", wl_lookup_hit, 128, 0, 1},
+    {"lookup_hit/len=256", wl_lookup_hit, 256, 0, 1},
+    {"lookup_hit/load=0.25", wl_lookup_hit_load, HT_BENCH_KEY_LENGTH, 0.25, 1},
+    {"lookup_hit/load=0.50", wl_lookup_hit_load, HT_BENCH_KEY_LENGTH, 0.50, 1},
+    {"lookup_hit/load=0.60", wl_lookup_hit_load, HT_BENCH_KEY_LENGTH, 0.60, 1},
+    {"lookup_hit/load=0.69", wl_lookup_hit_load, HT_BENCH_KEY_LENGTH, 0.69, 1},
+    {"lookup_miss/load=0.25", wl_lookup_miss_load, HT_BENCH_KEY_LENGTH, 0.25, 1},
+    {"lookup_miss/load=0.50", wl_lookup_miss_load, HT_BENCH_KEY_LENGTH, 0.50, 1},
+    {"lookup_miss/load=0.60", wl_lookup_miss_load, HT_BENCH_KEY_LENGTH, 0.60, 1},
+    {"lookup_miss/load=0.69", wl_lookup_miss_load, HT_BENCH_KEY_LENGTH, 0.69, 1},
+};
+
+static int compare_elapsed(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static bool measure(const BenchWorkload *workload, const BenchSpec *spec, size_t repeat, BenchResult *result) {
+    uint64_t *elapsed = malloc(repeat * sizeof(uint64_t));
+    BenchRun run;
+
+    if(!elapsed) {
+        fputs("Memory allocation failed for benchmark runs.\n", stderr);
+        return false;
+    }
+
+    for(size_t i = 0; i < repeat; i++) {
+        memset(&run, 0, sizeof(run));
+
+        if(!workload->run(spec, &run)) {
+            fprintf(stderr, "Workload %s failed.\n", workload->name);
+            free(elapsed);
+            return false;
+        }
+
+        elapsed[i] = run.elapsed;
+    }
+
+    qsort(elapsed, repeat, sizeof(uint64_t), compare_elapsed);
+
+    result->name = workload->name;
+    result->key_length = workload->key_length;
+    result->ops = run.ops;
+    result->ops_per_sec = (double)run.ops * 1e9 / (double)(elapsed[repeat / 2] ? elapsed[repeat / 2] : 1);
+    result->load_factor = run.load_factor;
+    result->bytes_per_entry = run.heap_bytes == SIZE_MAX || run.entries == 0 ? -1 : (double)run.heap_bytes / (double)run.entries;
+    free(elapsed);
+
+    BenchRun timed;
+
+    memset(&timed, 0, sizeof(timed));
+    timed.overhead = bench_timer_overhead();
+    timed.samples = malloc(spec->count * workload->max_ops_per_key * sizeof(uint32_t));
+
+    if(!timed.samples) {
+        fputs("Memory allocation failed for latency samples.\n", stderr);
+        return false;
+    }
+
+    if(!workload->run(spec, &timed)) {
+        fprintf(stderr, "Workload %s failed.\n", workload->name);
+        free(timed.samples);
+        return false;
+    }
+
+    result->latency = bench_latency(timed.samples, timed.ops);
+    free(timed.samples);
+
+    return true;
+}
+
+static void print_header(FILE *out) {
+    fprintf(out, "%-24s %12s %8s %8s %8s %8s %8s %10s %6s\n", "workload", "ops/s", "mean", "p50", "p90", "p99",
+            "p99.9", "bytes/ent", "load");
+}
+
+static void print_result(FILE *out, const BenchResult *result) {
+    fprintf(out, "%-24s %12.0f %8.1f %8.0f %8.0f %8.0f %8.0f ", result->name, result->ops_per_sec,
+            result->latency.mean, result->latency.p50, result->latency.p90, result->latency.p99,
+            result->latency.p999);
+
+    if(result->bytes_per_entry < 0) {
+        fprintf(out, "%10s", "-");
+    }
+    else {
+        fprintf(out, "%10.1f", result->bytes_per_entry);
+    }
+
+    fprintf(out, " %6.2f\n", result->load_factor);
+}
+
+static bool write_json(const char *path, const BenchResult *results, size_t count, const BenchSpec *spec,
+                       size_t repeat) {
+    FILE *out = fopen(path, "w");
+
+    if(!out) {
+        perror(path);
+        return false;
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"htbench\",\n  \"format\": 1,\n");
+    fprintf(out, "  \"count\": %zu,\n  \"repeat\": %zu,\n  \"seed\": %llu,\n", spec->count, repeat,
+            (unsigned long long)spec->seed);
+#ifdef __VERSION__
+    fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(out, "  \"timer_overhead_ns\": %llu,\n  \"results\": [\n", (unsigned long long)bench_timer_overhead());
+
+    for(size_t i = 0; i < count; i++) {
+        const BenchResult *result = &results[i];
+
+        fprintf(out, "    {\"name\": \"%s\", \"key_length\": %zu, \"ops\": %zu, \"ops_per_sec\": %.0f, ", result->name,
+                result->key_length, result->ops, result->ops_per_sec);
+        fprintf(out, "\"ns_per_op\": {\"mean\": %.1f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"p999\": %.0f, "
+                "\"max\": %.0f}, ", result->latency.mean, result->latency.p50, result->latency.p90,
+                result->latency.p99, result->latency.p999, result->latency.max);
+
+        if(result->bytes_per_entry < 0) {
+            fprintf(out, "\"bytes_per_entry\": null, ");
+        }
+        else {
+            fprintf(out, "\"bytes_per_entry\": %.1f, ", result->bytes_per_entry);
+        }
+
+        fprintf(out, "\"load_factor\": %.3f}%s\n", result->load_factor, i + 1 < count ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+
+    if(fclose(out) != 0) {
+        perror(path);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t count = 1000000;
+    size_t repeat = 3;
+    uint64_t seed = 1;
+    const char *filter = NULL;
+    const char *output = NULL;
+    int option;
+
+    while((option = getopt(argc, argv, "n:r:s:w:o:")) != -1) {
+        if(option == 'n') {
+            count = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'r') {
+            repeat = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 's') {
+            seed = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'w') {
+            filter = optarg;
+        }
+        else if(option == 'o') {
+            output = optarg;
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if(count == 0 || repeat == 0 || optind != argc) {
+        usage();
+        return 2;
+    }
+
+    size_t workload_count = sizeof(workloads) / sizeof(workloads[0]);
+    BenchResult *results = calloc(workload_count, sizeof(BenchResult));
+    size_t *order = bench_order(count, seed);
+    size_t result_count = 0;
+    bool ok = results && order;
+
+    if(!results) {
+        fputs("Memory allocation failed for benchmark results.\n", stderr);
+    }
+
+    if(ok) {
+        print_header(stdout);
+    }
+
+    for(size_t i = 0; i < workload_count && ok; i++) {
+        const BenchWorkload *workload = &workloads[i];
+        BenchKeys hits, misses;
+
+        if(filter && !strstr(workload->name, filter)) {
+            continue;
+        }
+
+        if(!bench_keys_init(&hits, count, workload->key_length, 'h', seed)) {
+            ok = false;
+            break;
+        }
+
+        if(!bench_keys_init(&misses, count, workload->key_length, 'm', seed)) {
+            bench_keys_free(&hits);
+            ok = false;
+            break;
+        }
+
+        BenchSpec spec = {count, workload->param, seed, &hits, &misses, order};
+
+        ok = measure(workload, &spec, repeat, &results[result_count]);
+
+        if(ok) {
+            print_result(stdout, &results[result_count++]);
+            fflush(stdout);
+        }
+
+        bench_keys_free(&hits);
+        bench_keys_free(&misses);
+    }
+
+    if(ok && output) {
+        BenchSpec spec = {count, 0, seed, NULL, NULL, NULL};
+
+        ok = write_json(output, results, result_count, &spec, repeat);
+    }
+
+    free(results);
+    free(order);
+
+    return ok ? 0 : 1;
+}
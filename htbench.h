@@ -0,0 +1,216 @@
+/*
+    Benchmark Support
+
+    Description:
+    Key generators, timing and statistics shared by the benchmark programs, so that
+    every benchmark runs on identical keys for a given seed. Header-only and valid C
+    and C++; it is not part of the installed library.
+
+    Keys are a prefix character, the key's index in base 62 (least significant digit
+    first, so keys diverge early as real identifiers tend to), and seeded random
+    characters up to the requested length. Key sets built with different prefixes are
+    disjoint, which gives lookups that are guaranteed to miss.
+*/
+
+#ifndef HT_BENCH_H
+#define HT_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define HT_BENCH_MIN_KEY_LENGTH 8 // prefix and 7 base-62 digits: distinct up to 62^7 keys
+
+typedef struct {
+    char *data;     // all keys, NUL-terminated, length + 1 bytes apart
+    char **keys;
+    size_t count;
+    size_t length;
+} BenchKeys;
+
+typedef struct {
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double max;
+} BenchLatency;
+
+/*
+    One operation of a benchmark run. run is a struct with `samples` (per-operation
+    latencies in ns, or NULL when only throughput is measured), `overhead` (the clock
+    cost subtracted from each sample) and `ops` (operations so far).
+*/
+#define BENCH_OP(run, op) \
+    do { \
+        if((run)->samples) { \
+            uint64_t op_start_ = bench_now_ns(); \
+            op; \
+            uint64_t op_time_ = bench_now_ns() - op_start_; \
+            (run)->samples[(run)->ops] = (uint32_t)(op_time_ > (run)->overhead ? op_time_ - (run)->overhead : 0); \
+        } \
+        else { \
+            op; \
+        } \
+        (run)->ops++; \
+    } while(0)
+
+static const char bench_alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+static inline uint64_t bench_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Cost of reading the clock, subtracted from per-operation latencies
+static inline uint64_t bench_timer_overhead(void) {
+    uint64_t best = UINT64_MAX;
+
+    for(int i = 0; i < 1000; i++) {
+        uint64_t start = bench_now_ns();
+        uint64_t elapsed = bench_now_ns() - start;
+
+        best = elapsed < best ? elapsed : best;
+    }
+
+    return best;
+}
+
+static inline bool bench_keys_init(BenchKeys *set, size_t count, size_t length, char prefix, uint64_t seed) {
+    if(length < HT_BENCH_MIN_KEY_LENGTH) {
+        fprintf(stderr, "Benchmark keys must be at least %d characters long.\n", HT_BENCH_MIN_KEY_LENGTH);
+        return false;
+    }
+
+    set->data = (char *)malloc(count * (length + 1));
+    set->keys = (char **)malloc(count * sizeof(char *));
+    set->count = count;
+    set->length = length;
+
+    if(!set->data || !set->keys) {
+        fputs("Memory allocation failed for benchmark keys.\n", stderr);
+        free(set->data);
+        free(set->keys);
+        return false;
+    }
+
+    uint64_t state = seed ^ (uint64_t)(unsigned char)prefix << 56;
+
+    for(size_t i = 0; i < count; i++) {
+        char *key = set->data + i * (length + 1);
+        size_t index = i;
+
+        key[0] = prefix;
+
+        for(size_t j = 1; j < HT_BENCH_MIN_KEY_LENGTH; j++) {
+            key[j] = bench_alphabet[index % 62];
+            index /= 62;
+        }
+
+        for(size_t j = HT_BENCH_MIN_KEY_LENGTH; j < length; j++) {
+            key[j] = bench_alphabet[bench_random(&state) % 62];
+        }
+
+        key[length] = '\0';
+        set->keys[i] = key;
+    }
+
+    return true;
+}
+
+static inline void bench_keys_free(BenchKeys *set) {
+    free(set->data);
+    free(set->keys);
+    set->data = NULL;
+    set->keys = NULL;
+    set->count = 0;
+}
+
+// Random permutation of 0..count-1, so that accesses do not follow insertion order
+static inline size_t *bench_order(size_t count, uint64_t seed) {
+    size_t *order = (size_t *)malloc(count * sizeof(size_t));
+
+    if(!order) {
+        fputs("Memory allocation failed for benchmark access order.\n", stderr);
+        return NULL;
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    for(size_t i = count; i > 1; i--) {
+        size_t j = bench_random(&seed) % i;
+        size_t swap = order[i - 1];
+
+        order[i - 1] = order[j];
+        order[j] = swap;
+    }
+
+    return order;
+}
+
+// Bytes currently allocated through malloc, or SIZE_MAX where the C library cannot tell
+static inline size_t bench_heap_bytes(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks + info.hblkhd;
+#else
+    return SIZE_MAX;
+#endif
+}
+
+static inline int bench_compare_samples(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// Sorts the samples in place
+static inline BenchLatency bench_latency(uint32_t *samples, size_t count) {
+    BenchLatency latency = {0, 0, 0, 0, 0, 0};
+    double total = 0;
+
+    if(count == 0) {
+        return latency;
+    }
+
+    qsort(samples, count, sizeof(uint32_t), bench_compare_samples);
+
+    for(size_t i = 0; i < count; i++) {
+        total += samples[i];
+    }
+
+    latency.mean = total / (double)count;
+    latency.p50 = samples[count / 2];
+    latency.p90 = samples[(size_t)((double)count * 0.90)];
+    latency.p99 = samples[(size_t)((double)count * 0.99)];
+    latency.p999 = samples[(size_t)((double)count * 0.999)];
+    latency.max = samples[count - 1];
+
+    return latency;
+}
+
+#endif
@@ -0,0 +1,658 @@
+/*
+    Comparative Benchmark
+
+    Description:
+    Runs the same workloads, on the same generated keys as `htbench`, against several
+    hash map implementations:
+    - HashTable: the C table (`hashtable.h`)
+    - HT_DEFINE: a table generated by `hashtable_define.h` for string keys
+    - ht::hash_map: the C++ container (`hashtable.hpp`)
+    - std::unordered_map: the standard library's node-based map
+    - absl::flat_hash_map: Abseil's open addressing map (SwissTable), whose headers are
+      vendored in `third_party/abseil`; built only with HT_COMPARE_ABSL, when the
+      matching Abseil libraries are installed
+
+    Every map stores `std::string_view` (or `const char *`) keys that point into the
+    key set, with 64-bit values, so none of them pays for copying keys. Each one is
+    wrapped in an adapter with the same four operations; another implementation is
+    compared by adding its sources under `third_party` and writing one more adapter.
+
+    Reported per implementation:
+    - throughput and latency percentiles per workload, measured as in `htbench`
+    - peak RSS of a child process that runs only that implementation's workloads;
+      the key sets and latency buffers are the same for every implementation, so
+      differences come from the maps
+    - build time: the best of three compilations of a small translation unit that
+      includes the implementation's header and instantiates it
+
+    Usage:
+        htcompare [-B] [-n count] [-r repeat] [-s seed] [-m filter] [-o report.json]
+
+    `-B` skips build timing, and `filter` runs only implementations whose name
+    contains it. Other options are those of `htbench`.
+*/
+
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern "C" {
+#include "hashtable.h"
+}
+
+#include "hashtable.hpp"
+#include "hashtable_define.h"
+#include "htbench.h"
+
+#ifdef HT_COMPARE_ABSL
+#include "absl/container/flat_hash_map.h"
+#endif
+
+#ifndef HT_COMPARE_CXX
+#define HT_COMPARE_CXX "c++"
+#endif
+
+#ifndef HT_COMPARE_INCLUDE
+#define HT_COMPARE_INCLUDE "."
+#endif
+
+#define HT_COMPARE_KEY_LENGTH 16
+#define HT_COMPARE_TABLE_LOAD 0.7
+
+HT_DEFINE(compare_table, const char *, uint64_t, ht_hash_str, ht_eq_str)
+
+namespace {
+
+struct CTableMap {
+    static constexpr const char *name = "HashTable";
+    static constexpr const char *source =
+        "extern \"C\" {\n#include \"hashtable.h\"\n}\n"
+        "size_t use(HashTable *ht, const char *key) {\n"
+        "    void *value;\n"
+        "    ht_set(ht, key, (void *)key);\n"
+        "    size_t found = ht_try_get(ht, key, &value);\n"
+        "    ht_delete(ht, key);\n"
+        "    return found + ht_count(ht);\n"
+        "}\n";
+
+    explicit CTableMap(size_t reserve) : ht(ht_init(reserve ? (size_t)(reserve / HT_COMPARE_TABLE_LOAD) + 1 : 0)) {}
+
+    ~CTableMap() {
+        ht_free(&ht);
+    }
+
+    bool set(std::string_view key, uint64_t value) {
+        return ht_set(ht, key.data(), (void *)(uintptr_t)value);
+    }
+
+    bool get(std::string_view key, uint64_t *value) {
+        void *found;
+
+        if(!ht_try_get(ht, key.data(), &found)) {
+            return false;
+        }
+
+        *value = (uint64_t)(uintptr_t)found;
+
+        return true;
+    }
+
+    void erase(std::string_view key) {
+        ht_delete(ht, key.data());
+    }
+
+    HashTable *ht;
+};
+
+struct DefineMap {
+    static constexpr const char *name = "HT_DEFINE";
+    static constexpr const char *source =
+        "#include \"hashtable_define.h\"\n"
+        "HT_DEFINE(strmap, const char *, uint64_t, ht_hash_str, ht_eq_str)\n"
+        "size_t use(strmap *t, const char *key) {\n"
+        "    uint64_t value;\n"
+        "    strmap_set(t, key, 1);\n"
+        "    size_t found = strmap_try_get(t, key, &value);\n"
+        "    strmap_delete(t, key);\n"
+        "    return found + strmap_count(t);\n"
+        "}\n";
+
+    explicit DefineMap(size_t reserve)
+        : table(compare_table_init(reserve ? (size_t)(reserve / HT_COMPARE_TABLE_LOAD) + 1 : 0)) {}
+
+    ~DefineMap() {
+        compare_table_free(&table);
+    }
+
+    bool set(std::string_view key, uint64_t value) {
+        return compare_table_set(table, key.data(), value);
+    }
+
+    bool get(std::string_view key, uint64_t *value) {
+        return compare_table_try_get(table, key.data(), value);
+    }
+
+    void erase(std::string_view key) {
+        compare_table_delete(table, key.data());
+    }
+
+    compare_table *table;
+};
+
+// Adapter for any map with the std::unordered_map interface
+template<class Map>
+struct StdInterfaceMap {
+    explicit StdInterfaceMap(size_t reserve) {
+        map.reserve(reserve);
+    }
+
+    bool set(std::string_view key, uint64_t value) {
+        map.insert_or_assign(key, value);
+
+        return true;
+    }
+
+    bool get(std::string_view key, uint64_t *value) {
+        auto it = map.find(key);
+
+        if(it == map.end()) {
+            return false;
+        }
+
+        *value = it->second;
+
+        return true;
+    }
+
+    void erase(std::string_view key) {
+        map.erase(key);
+    }
+
+    Map map;
+};
+
+struct HppMap : StdInterfaceMap<ht::hash_map<std::string_view, uint64_t>> {
+    static constexpr const char *name = "ht::hash_map";
+    static constexpr const char *source =
+        "#include \"hashtable.hpp\"\n"
+        "size_t use(ht::hash_map<std::string_view, uint64_t> &map, std::string_view key) {\n"
+        "    map.insert_or_assign(key, 1);\n"
+        "    size_t found = map.find(key) != map.end();\n"
+        "    map.erase(key);\n"
+        "    return found + map.size();\n"
+        "}\n";
+
+    using StdInterfaceMap::StdInterfaceMap;
+};
+
+struct StdMap : StdInterfaceMap<std::unordered_map<std::string_view, uint64_t>> {
+    static constexpr const char *name = "std::unordered_map";
+    static constexpr const char *source =
+        "#include <string_view>\n#include <unordered_map>\n"
+        "size_t use(std::unordered_map<std::string_view, uint64_t> &map, std::string_view key) {\n"
+        "    map.insert_or_assign(key, 1);\n"
+        "    size_t found = map.find(key) != map.end();\n"
+        "    map.erase(key);\n"
+        "    return found + map.size();\n"
+        "}\n";
+
+    using StdInterfaceMap::StdInterfaceMap;
+};
+
+#ifdef HT_COMPARE_ABSL
+struct AbslMap : StdInterfaceMap<absl::flat_hash_map<std::string_view, uint64_t>> {
+    static constexpr const char *name = "absl::flat_hash_map";
+    static constexpr const char *source =
+        "#include \"absl/container/flat_hash_map.h\"\n"
+        "size_t use(absl::flat_hash_map<std::string_view, uint64_t> &map, std::string_view key) {\n"
+        "    map.insert_or_assign(key, 1);\n"
+        "    size_t found = map.find(key) != map.end();\n"
+        "    map.erase(key);\n"
+        "    return found + map.size();\n"
+        "}\n";
+
+    using StdInterfaceMap::StdInterfaceMap;
+};
+#endif
+
+struct CompareSpec {
+    size_t count;
+    size_t repeat;
+    uint64_t seed;
+    double read_ratio;
+    const BenchKeys *hits;
+    const BenchKeys *misses;
+    const size_t *order;
+};
+
+struct CompareRun {
+    uint32_t *samples;
+    uint64_t overhead;
+    uint64_t start;
+    uint64_t elapsed;
+    size_t ops;
+    uint64_t sink;
+};
+
+// Keys have a known length, which spares every adapter a strlen
+std::string_view key_at(const BenchKeys *keys, size_t index) {
+    return std::string_view(keys->keys[index], keys->length);
+}
+
+template<class Map>
+bool wl_insert(const CompareSpec &spec, CompareRun *run, size_t reserve) {
+    Map map(reserve);
+    bool ok = true;
+
+    run->start = bench_now_ns();
+
+    for(size_t i = 0; i < spec.count && ok; i++) {
+        size_t index = spec.order[i];
+
+        BENCH_OP(run, ok = map.set(key_at(spec.hits, index), index + 1));
+    }
+
+    run->elapsed = bench_now_ns() - run->start;
+
+    return ok;
+}
+
+template<class Map>
+bool wl_insert_empty(const CompareSpec &spec, CompareRun *run) {
+    return wl_insert<Map>(spec, run, 0);
+}
+
+template<class Map>
+bool wl_insert_reserved(const CompareSpec &spec, CompareRun *run) {
+    return wl_insert<Map>(spec, run, spec.count);
+}
+
+template<class Map>
+bool filled(const CompareSpec &spec, Map &map, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        if(!map.set(key_at(spec.hits, i), i + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<class Map>
+bool wl_lookup(const CompareSpec &spec, CompareRun *run, const BenchKeys *keys) {
+    Map map(spec.count);
+    uint64_t value = 0;
+
+    if(!filled(spec, map, spec.count)) {
+        return false;
+    }
+
+    run->start = bench_now_ns();
+
+    for(size_t i = 0; i < spec.count; i++) {
+        std::string_view key = key_at(keys, spec.order[i]);
+
+        BENCH_OP(run, run->sink += map.get(key, &value) + value);
+    }
+
+    run->elapsed = bench_now_ns() - run->start;
+
+    return true;
+}
+
+template<class Map>
+bool wl_lookup_hit(const CompareSpec &spec, CompareRun *run) {
+    return wl_lookup<Map>(spec, run, spec.hits);
+}
+
+template<class Map>
+bool wl_lookup_miss(const CompareSpec &spec, CompareRun *run) {
+    return wl_lookup<Map>(spec, run, spec.misses);
+}
+
+template<class Map>
+bool wl_delete_churn(const CompareSpec &spec, CompareRun *run) {
+    Map map(spec.count);
+    bool ok = filled(spec, map, spec.count);
+
+    run->start = bench_now_ns();
+
+    for(size_t i = 0; i < spec.count && ok; i++) {
+        BENCH_OP(run, map.erase(key_at(spec.hits, spec.order[i])));
+        BENCH_OP(run, ok = map.set(key_at(spec.misses, i), i + 1));
+    }
+
+    run->elapsed = bench_now_ns() - run->start;
+
+    return ok;
+}
+
+template<class Map>
+bool wl_mixed(const CompareSpec &spec, CompareRun *run) {
+    Map map(spec.count);
+    uint64_t state = spec.seed;
+    uint64_t read_threshold = (uint64_t)(spec.read_ratio * (double)UINT32_MAX);
+    uint64_t value = 0;
+    bool ok = filled(spec, map, spec.count / 2);
+
+    run->start = bench_now_ns();
+
+    for(size_t i = 0; i < spec.count && ok; i++) {
+        uint64_t r = bench_random(&state);
+        size_t index = (r >> 32) % spec.count;
+        std::string_view key = key_at(spec.hits, index);
+
+        if((r & UINT32_MAX) < read_threshold) {
+            BENCH_OP(run, run->sink += map.get(key, &value) + value);
+        }
+        else {
+            BENCH_OP(run, ok = map.set(key, index + 1));
+        }
+    }
+
+    run->elapsed = bench_now_ns() - run->start;
+
+    return ok;
+}
+
+struct CompareWorkload {
+    const char *name;
+    double read_ratio;
+    size_t max_ops_per_key;
+};
+
+const CompareWorkload workloads[] = {
+    {"insert_empty", 0, 1},
+    {"insert_reserved", 0, 1},
+    {"lookup_hit", 0, 1},
+    {"lookup_miss", 0, 1},
+    {"delete_churn", 0, 2},
+    {"mixed_r90", 0.9, 1},
+    {"mixed_r50", 0.5, 1},
+};
+
+// Same order as workloads
+template<class Map>
+bool run_workload(size_t workload, const CompareSpec &spec, CompareRun *run) {
+    static bool (*const functions[])(const CompareSpec &, CompareRun *) = {
+        wl_insert_empty<Map>, wl_insert_reserved<Map>, wl_lookup_hit<Map>, wl_lookup_miss<Map>,
+        wl_delete_churn<Map>, wl_mixed<Map>, wl_mixed<Map>,
+    };
+
+    return functions[workload](spec, run);
+}
+
+int compare_elapsed(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// Runs every workload on Map; called in a child process so that its peak RSS is the map's own
+template<class Map>
+bool compare_map(const CompareSpec &base, FILE *json) {
+    BenchKeys hits, misses;
+
+    if(!bench_keys_init(&hits, base.count, HT_COMPARE_KEY_LENGTH, 'h', base.seed)) {
+        return false;
+    }
+
+    if(!bench_keys_init(&misses, base.count, HT_COMPARE_KEY_LENGTH, 'm', base.seed)) {
+        bench_keys_free(&hits);
+        return false;
+    }
+
+    size_t *order = bench_order(base.count, base.seed);
+    uint64_t *elapsed = (uint64_t *)malloc(base.repeat * sizeof(uint64_t));
+    uint32_t *samples = (uint32_t *)malloc(base.count * 2 * sizeof(uint32_t));
+    size_t workload_count = sizeof(workloads) / sizeof(workloads[0]);
+    bool ok = order && elapsed && samples;
+
+    if(!elapsed || !samples) {
+        fputs("Memory allocation failed for benchmark runs.\n", stderr);
+    }
+
+    if(json) {
+        fprintf(json, "\"results\": [\n");
+    }
+
+    for(size_t i = 0; i < workload_count && ok; i++) {
+        CompareSpec spec = base;
+        CompareRun run;
+
+        spec.read_ratio = workloads[i].read_ratio;
+        spec.hits = &hits;
+        spec.misses = &misses;
+        spec.order = order;
+
+        for(size_t j = 0; j < spec.repeat && ok; j++) {
+            memset(&run, 0, sizeof(run));
+            ok = run_workload<Map>(i, spec, &run);
+            elapsed[j] = run.elapsed;
+        }
+
+        size_t ops = run.ops;
+
+        memset(&run, 0, sizeof(run));
+        run.samples = samples;
+        run.overhead = bench_timer_overhead();
+        ok = ok && run_workload<Map>(i, spec, &run);
+
+        if(!ok) {
+            fprintf(stderr, "Workload %s failed for %s.\n", workloads[i].name, Map::name);
+            break;
+        }
+
+        qsort(elapsed, spec.repeat, sizeof(uint64_t), compare_elapsed);
+
+        double ops_per_sec = (double)ops * 1e9 / (double)(elapsed[spec.repeat / 2] ? elapsed[spec.repeat / 2] : 1);
+        BenchLatency latency = bench_latency(samples, run.ops);
+
+        printf("%-20s %-16s %12.0f %8.1f %8.0f %8.0f %8.0f %8.0f\n", Map::name, workloads[i].name, ops_per_sec,
+               latency.mean, latency.p50, latency.p90, latency.p99, latency.p999);
+        fflush(stdout);
+
+        if(json) {
+            fprintf(json, "      {\"name\": \"%s\", \"ops\": %zu, \"ops_per_sec\": %.0f, ", workloads[i].name, ops,
+                    ops_per_sec);
+            fprintf(json, "\"ns_per_op\": {\"mean\": %.1f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, "
+                    "\"p999\": %.0f, \"max\": %.0f}}%s\n", latency.mean, latency.p50, latency.p90, latency.p99,
+                    latency.p999, latency.max, i + 1 < workload_count ? "," : "");
+        }
+    }
+
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-20s peak RSS %ld KiB\n", Map::name, usage.ru_maxrss);
+
+    if(json) {
+        fprintf(json, "    ], \"peak_rss_kb\": %ld}", usage.ru_maxrss);
+    }
+
+    free(samples);
+    free(elapsed);
+    free(order);
+    bench_keys_free(&hits);
+    bench_keys_free(&misses);
+
+    return ok;
+}
+
+// Best of three compilations of the adapter's source, in milliseconds, or a negative value on failure
+double build_time(const char *source) {
+    static const char command[] = HT_COMPARE_CXX " -std=c++17 -O2 -I" HT_COMPARE_INCLUDE " -I" HT_COMPARE_INCLUDE
+                                  "/third_party/abseil -x c++ -c -o /dev/null -";
+    double best = -1;
+
+    for(int i = 0; i < 3; i++) {
+        uint64_t start = bench_now_ns();
+        FILE *compiler = popen(command, "w");
+
+        if(!compiler) {
+            perror("popen");
+            return -1;
+        }
+
+        fputs(source, compiler);
+
+        if(pclose(compiler) != 0) {
+            fprintf(stderr, "Compiling with `%s` failed.\n", command);
+            return -1;
+        }
+
+        double elapsed = (double)(bench_now_ns() - start) / 1e6;
+
+        best = best < 0 || elapsed < best ? elapsed : best;
+    }
+
+    return best;
+}
+
+struct CompareOptions {
+    CompareSpec spec;
+    const char *filter;
+    bool build_times;
+    FILE *json;
+    bool first;
+};
+
+template<class Map>
+bool compare(CompareOptions *options) {
+    if(options->filter && !strstr(Map::name, options->filter)) {
+        return true;
+    }
+
+    double build_ms = options->build_times ? build_time(Map::source) : -1;
+
+    if(options->build_times) {
+        printf("%-20s build %.0f ms\n", Map::name, build_ms);
+    }
+
+    if(options->json) {
+        fprintf(options->json, "%s    {\"name\": \"%s\", ", options->first ? "" : ",\n", Map::name);
+
+        if(build_ms < 0) {
+            fprintf(options->json, "\"build_ms\": null, ");
+        }
+        else {
+            fprintf(options->json, "\"build_ms\": %.1f, ", build_ms);
+        }
+
+        fflush(options->json);
+    }
+
+    options->first = false;
+    fflush(stdout);
+
+    pid_t pid = fork();
+
+    if(pid < 0) {
+        perror("fork");
+        return false;
+    }
+
+    if(pid == 0) {
+        bool ok = compare_map<Map>(options->spec, options->json);
+
+        if(options->json) {
+            fflush(options->json);
+        }
+
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+
+    int status;
+
+    if(waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void usage() {
+    fputs("Usage: htcompare [-B] [-n count] [-r repeat] [-s seed] [-m filter] [-o report.json]\n", stderr);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    CompareOptions options = {{1000000, 3, 1, 0, NULL, NULL, NULL}, NULL, true, NULL, true};
+    const char *output = NULL;
+    int option;
+
+    while((option = getopt(argc, argv, "Bn:r:s:m:o:")) != -1) {
+        if(option == 'B') {
+            options.build_times = false;
+        }
+        else if(option == 'n') {
+            options.spec.count = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'r') {
+            options.spec.repeat = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 's') {
+            options.spec.seed = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'm') {
+            options.filter = optarg;
+        }
+        else if(option == 'o') {
+            output = optarg;
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if(options.spec.count == 0 || options.spec.repeat == 0 || optind != argc) {
+        usage();
+        return 2;
+    }
+
+    if(output) {
+        options.json = fopen(output, "w");
+
+        if(!options.json) {
+            perror(output);
+            return 1;
+        }
+
+        fprintf(options.json, "{\n  \"benchmark\": \"htcompare\",\n  \"format\": 1,\n");
+        fprintf(options.json, "  \"count\": %zu,\n  \"repeat\": %zu,\n  \"seed\": %llu,\n  \"key_length\": %d,\n",
+                options.spec.count, options.spec.repeat, (unsigned long long)options.spec.seed,
+                HT_COMPARE_KEY_LENGTH);
+#ifdef __VERSION__
+        fprintf(options.json, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+        fprintf(options.json, "  \"implementations\": [\n");
+    }
+
+    printf("%-20s %-16s %12s %8s %8s %8s %8s %8s\n", "implementation", "workload", "ops/s", "mean", "p50", "p90",
+           "p99", "p99.9");
+
+    bool ok = compare<CTableMap>(&options) && compare<DefineMap>(&options) && compare<HppMap>(&options) &&
+              compare<StdMap>(&options);
+#ifdef HT_COMPARE_ABSL
+    ok = ok && compare<AbslMap>(&options);
+#endif
+
+    if(options.json) {
+        fprintf(options.json, "\n  ]\n}\n");
+
+        if(fclose(options.json) != 0) {
+            perror(output);
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/*
+    Static Table Generator
+    
+    Description:
+    Generates C source for a frozen hash table from a list of keys known at build
+    time, such as keyword or command tables. The generated table is a `const
+    HashFrozen` built from static const arrays: it needs no initialization and no
+    heap, lives in read-only data shared by every process running the binary, and is
+    queried with `ht_frozen_get`, `ht_frozen_try_get` and `ht_frozen_has`.
+
+    Input has one entry per line: the key, optionally followed by a tab and its value.
+    Values are emitted as string literals, or with `-e` as C expressions converted to
+    `void *` (for example enum constants). Keys without a value map to NULL. Empty
+    lines are skipped, and when a key appears twice the later value wins.
+
+    Usage:
+        htgen [-e] [-i header.h] [-n name] [-o output.c] [input]
+
+    `-i` adds an include of the header that defines what the value expressions use.
+    `name` is the C identifier of the generated table (default `table`). Input defaults
+    to standard input and output to standard output. Declare the table where it is
+    used with `extern const HashFrozen name;`.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hashfrozen.h"
+
+typedef struct {
+    const char *name;
+    const char *include; // header the value expressions need, or NULL
+    bool expressions;
+} GeneratorOptions;
+
+static void usage(void) {
+    fputs("Usage: htgen [-e] [-i header.h] [-n name] [-o output.c] [input]\n", stderr);
+}
+
+static bool is_identifier(const char *name) {
+    if(!name || !(isalpha((unsigned char)*name) || *name == '_')) {
+        return false;
+    }
+
+    for(const char *c = name; *c; c++) {
+        if(!isalnum((unsigned char)*c) && *c != '_') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Octal escapes are always three digits, so a following digit cannot extend them
+static void emit_string(FILE *out, const char *text) {
+    fputc('"', out);
+
+    for(const unsigned char *c = (const unsigned char *)text; *c; c++) {
+        if(*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        }
+        else if(isprint(*c) && *c != '?') {
+            fputc(*c, out);
+        }
+        else {
+            fprintf(out, "\\%03o", *c);
+        }
+    }
+
+    fputc('"', out);
+}
+
+static void emit_value(FILE *out, const char *value, const GeneratorOptions *options) {
+    if(!value) {
+        fputs("NULL", out);
+    }
+    else if(options->expressions) {
+        fprintf(out, "(void *)(%s)", value);
+    }
+    else {
+        fputs("(void *)", out);
+        emit_string(out, value);
+    }
+}
+
+static const char *separator(size_t i) {
+    return i == 0 ? "\n    " : i % 16 ? ", " : ",\n    ";
+}
+
+static void emit_table(FILE *out, const HashFrozen *frozen, const GeneratorOptions *options) {
+    const char *name = options->name;
+
+    fputs("/* Generated by htgen; do not edit. */\n\n#include \"hashfrozen.h\"\n", out);
+
+    if(options->include) {
+        fprintf(out, "#include \"%s\"\n", options->include);
+    }
+
+    fputc('\n', out);
+
+    if(frozen->count == 0) {
+        fprintf(out, "const HashFrozen %s = {0};\n", name);
+        return;
+    }
+
+    fprintf(out, "static const uint16_t %s_pilots[%zu] = {", name, frozen->bucket_count);
+
+    for(size_t i = 0; i < frozen->bucket_count; i++) {
+        fprintf(out, "%s%u", separator(i), frozen->pilots[i]);
+    }
+
+    fprintf(out, "\n};\n\nstatic const uint32_t %s_remap[%zu] = {", name, frozen->table_size - frozen->count);
+
+    for(size_t i = 0; i < frozen->table_size - frozen->count; i++) {
+        fprintf(out, "%s%u", separator(i), frozen->remap[i]);
+    }
+
+    fprintf(out, "\n};\n\nstatic const HashFrozenEntry %s_entries[%zu] = {\n", name, frozen->count);
+
+    for(size_t i = 0; i < frozen->count; i++) {
+        fputs("    {", out);
+        emit_string(out, frozen->entries[i].key);
+        fputs(", ", out);
+        emit_value(out, frozen->entries[i].value, options);
+        fputs("},\n", out);
+    }
+
+    fprintf(out, "};\n\nconst HashFrozen %s = {\n", name);
+    fprintf(out, "    %zu, %zu, %zu, %zu, 0x%016llxULL,\n", frozen->count, frozen->table_size, frozen->bucket_count, frozen->dense_buckets, (unsigned long long)frozen->seed);
+    fprintf(out, "    %s_pilots, %s_remap, %s_entries\n};\n", name, name, name);
+}
+
+// Reads "key" or "key<TAB>value" lines into ht; the lines stay allocated for the keys' lifetime
+static bool read_entries(FILE *in, HashTable *ht) {
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    while((length = getline(&line, &capacity, in)) >= 0) {
+        while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+
+        if(length == 0) {
+            continue;
+        }
+
+        char *value = strchr(line, '\t');
+
+        if(value) {
+            *value++ = '\0';
+        }
+
+        if(!ht_set(ht, line, value)) {
+            free(line);
+            return false;
+        }
+
+        line = NULL;
+        capacity = 0;
+    }
+
+    free(line);
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    GeneratorOptions options = {"table", NULL, false};
+    const char *output = NULL;
+    int option;
+
+    while((option = getopt(argc, argv, "ei:n:o:")) != -1) {
+        if(option == 'e') {
+            options.expressions = true;
+        }
+        else if(option == 'i') {
+            options.include = optarg;
+        }
+        else if(option == 'n') {
+            options.name = optarg;
+        }
+        else if(option == 'o') {
+            output = optarg;
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if(!is_identifier(options.name) || argc - optind > 1) {
+        usage();
+        return 2;
+    }
+
+    FILE *in = optind < argc ? fopen(argv[optind], "r") : stdin;
+
+    if(!in) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    HashTable *ht = ht_init(64);
+
+    if(!ht || !read_entries(in, ht)) {
+        return 1;
+    }
+
+    HashFrozen *frozen = ht_freeze(ht);
+    FILE *out = output ? fopen(output, "w") : stdout;
+
+    if(!frozen || !out) {
+        if(!out) {
+            perror(output);
+        }
+
+        return 1;
+    }
+
+    emit_table(out, frozen, &options);
+
+    if(fclose(out) != 0) {
+        perror(output ? output : "stdout");
+        return 1;
+    }
+
+    return 0;
+}
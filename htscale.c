@@ -0,0 +1,287 @@
+/*
+    Concurrent Scaling Check
+
+    Description:
+    Measures how the throughput of the lock-free table grows with the number of
+    threads. Every thread runs the same mixed workload on one shared table for a
+    fixed time: random reads, and writes that are half inserts or updates and half
+    deletes, over a key set of which about half is present. This is the traffic
+    that retires value boxes and old arrays, so the figures include reclamation.
+
+    Thread counts double from 1 up to the maximum, which is the number of online
+    CPUs unless given, and each is the median of several runs. Speedup and
+    efficiency are relative to one thread. Counts above the online CPUs share cores
+    and are marked as oversubscribed; they show that nothing collapses under
+    preemption but say nothing about scaling. With -e, the program exits non-zero
+    when the efficiency of any count that fits on the CPUs falls below the given
+    fraction, so it can serve as a check on a machine with enough cores.
+
+    Usage:
+        htscale [-n count] [-t max_threads] [-d milliseconds] [-p read_percent]
+                [-r repeat] [-s seed] [-e min_efficiency]
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "hashconcurrent.h"
+#include "htbench.h"
+
+typedef struct {
+    ConcurrentHashTable *ct;
+    BenchKeys *keys;
+    pthread_barrier_t *start;
+    atomic_bool *stop;
+    unsigned read_percent;
+    uint64_t seed;
+    uint64_t ops;
+    bool ok;
+} ScaleWorker;
+
+static void usage(void) {
+    fputs("usage: htscale [-n count] [-t max_threads] [-d milliseconds] [-p read_percent]\n"
+          "               [-r repeat] [-s seed] [-e min_efficiency]\n", stderr);
+}
+
+static void *scale_worker(void *arg) {
+    ScaleWorker *worker = arg;
+    uint64_t state = worker->seed;
+    uint64_t ops = 0;
+
+    pthread_barrier_wait(worker->start);
+
+    while(!atomic_load_explicit(worker->stop, memory_order_relaxed)) {
+        for(int i = 0; i < 64; i++) {
+            uint64_t r = bench_random(&state);
+            size_t k = (size_t)(r >> 8) % worker->keys->count;
+            const char *key = worker->keys->keys[k];
+
+            if(r % 100 < worker->read_percent) {
+                void *value;
+
+                if(ht_concurrent_try_get(worker->ct, key, &value) && value != (void *)(uintptr_t)(k + 1)) {
+                    worker->ok = false;
+                }
+            }
+            else if(r & 0x80) {
+                if(!ht_concurrent_set(worker->ct, key, (void *)(uintptr_t)(k + 1))) {
+                    worker->ok = false;
+                }
+            }
+            else {
+                ht_concurrent_delete(worker->ct, key);
+            }
+        }
+
+        ops += 64;
+    }
+
+    worker->ops = ops;
+
+    return NULL;
+}
+
+// Operations per second of one run with the given number of threads, or 0 on failure
+static double scale_run(BenchKeys *keys, size_t threads, uint64_t duration_ms, unsigned read_percent, uint64_t seed) {
+    ConcurrentHashTable *ct = ht_concurrent_init(keys->count);
+    pthread_t *ids = calloc(threads, sizeof(pthread_t));
+    ScaleWorker *workers = calloc(threads, sizeof(ScaleWorker));
+    pthread_barrier_t start;
+    atomic_bool stop = false;
+    size_t started = 0;
+    double rate = 0;
+    bool ok = ct && ids && workers;
+
+    if(!ok) {
+        fputs("Memory allocation failed for a scaling run.\n", stderr);
+    }
+
+    // Half of the keys are present when the clock starts
+    for(size_t i = 0; i < keys->count && ok; i += 2) {
+        ok = ht_concurrent_set(ct, keys->keys[i], (void *)(uintptr_t)(i + 1));
+    }
+
+    if(ok && pthread_barrier_init(&start, NULL, (unsigned)threads + 1) != 0) {
+        fputs("Cannot create the start barrier.\n", stderr);
+        ok = false;
+    }
+
+    if(ok) {
+        for(started = 0; started < threads; started++) {
+            workers[started] = (ScaleWorker) {
+                .ct = ct,
+                .keys = keys,
+                .start = &start,
+                .stop = &stop,
+                .read_percent = read_percent,
+                .seed = seed * 1000003 + started,
+                .ok = true,
+            };
+
+            if(pthread_create(&ids[started], NULL, scale_worker, &workers[started]) != 0) {
+                fprintf(stderr, "Cannot start thread %zu of %zu.\n", started + 1, threads);
+                ok = false;
+                break;
+            }
+        }
+
+        // Threads that did start are released and stopped at once
+        atomic_store(&stop, !ok);
+        pthread_barrier_wait(&start);
+
+        uint64_t begin = bench_now_ns();
+
+        if(ok) {
+            usleep((useconds_t)(duration_ms * 1000));
+        }
+
+        atomic_store(&stop, true);
+
+        uint64_t total = 0;
+
+        for(size_t i = 0; i < started; i++) {
+            pthread_join(ids[i], NULL);
+            total += workers[i].ops;
+
+            if(!workers[i].ok) {
+                fputs("A thread read a wrong value or failed to write.\n", stderr);
+                ok = false;
+            }
+        }
+
+        uint64_t elapsed = bench_now_ns() - begin;
+
+        pthread_barrier_destroy(&start);
+
+        if(ok && elapsed > 0) {
+            rate = (double)total * 1e9 / (double)elapsed;
+        }
+    }
+
+    free(workers);
+    free(ids);
+
+    if(ct) {
+        ht_concurrent_free(&ct);
+    }
+
+    return rate;
+}
+
+static int compare_rates(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    size_t count = 100000;
+    size_t max_threads = 0;
+    uint64_t duration_ms = 300;
+    unsigned read_percent = 90;
+    size_t repeat = 3;
+    uint64_t seed = 1;
+    double min_efficiency = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "n:t:d:p:r:s:e:")) != -1) {
+        if(option == 'n') {
+            count = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 't') {
+            max_threads = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'd') {
+            duration_ms = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'p') {
+            read_percent = (unsigned)strtoul(optarg, NULL, 10);
+        }
+        else if(option == 'r') {
+            repeat = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 's') {
+            seed = strtoull(optarg, NULL, 10);
+        }
+        else if(option == 'e') {
+            min_efficiency = strtod(optarg, NULL);
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t cpus = online > 0 ? (size_t)online : 1;
+
+    if(max_threads == 0) {
+        max_threads = cpus;
+    }
+
+    if(count == 0 || repeat == 0 || duration_ms == 0 || read_percent > 100 || optind != argc) {
+        usage();
+        return 2;
+    }
+
+    BenchKeys keys;
+    double *rates = calloc(repeat, sizeof(double));
+    double single = 0;
+    bool passed = true;
+
+    if(!rates || !bench_keys_init(&keys, count, 16, 'k', seed)) {
+        fputs("Memory allocation failed for the scaling check.\n", stderr);
+        free(rates);
+        return 1;
+    }
+
+    printf("%zu keys, %u%% reads, %zu online CPUs\n", count, read_percent, cpus);
+    printf("%8s %14s %9s %11s\n", "threads", "ops/s", "speedup", "efficiency");
+
+    // 1, 2, 4, ... and the maximum itself
+    for(size_t threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        for(size_t i = 0; i < repeat; i++) {
+            rates[i] = scale_run(&keys, threads, duration_ms, read_percent, seed + i);
+
+            if(rates[i] == 0) {
+                bench_keys_free(&keys);
+                free(rates);
+                return 1;
+            }
+        }
+
+        qsort(rates, repeat, sizeof(double), compare_rates);
+
+        double rate = rates[repeat / 2];
+
+        if(threads == 1) {
+            single = rate;
+        }
+
+        double speedup = rate / single;
+        double efficiency = speedup / (double)threads;
+        bool oversubscribed = threads > cpus;
+
+        printf("%8zu %14.0f %8.2fx %10.0f%%%s\n", threads, rate, speedup, efficiency * 100,
+               oversubscribed ? "  oversubscribed" : "");
+
+        if(!oversubscribed && efficiency < min_efficiency) {
+            passed = false;
+        }
+
+        if(threads == max_threads) {
+            break;
+        }
+    }
+
+    if(!passed) {
+        fprintf(stderr, "Efficiency fell below %.0f%% within the online CPUs.\n", min_efficiency * 100);
+    }
+
+    bench_keys_free(&keys);
+    free(rates);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+    Test Support
+
+    Description:
+    Minimal checking helpers for the behaviour tests in this directory, valid C and
+    C++. Each test is a standalone program that exits with status 1 at the first
+    failed check, after printing where it failed; `make test` builds and runs them all.
+*/
+
+#ifndef HT_TEST_H
+#define HT_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while(0)
+
+// Creates an empty temporary file and writes its path into path (at least 32 bytes)
+static inline void test_temp_path(char *path) {
+    strcpy(path, "/tmp/ht_test_XXXXXX");
+
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    close(fd);
+}
+
+static inline unsigned char *test_read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+
+    CHECK(file != NULL);
+    CHECK(fseek(file, 0, SEEK_END) == 0);
+
+    long size = ftell(file);
+    unsigned char *data = (unsigned char *)malloc(size > 0 ? size : 1);
+
+    CHECK(size >= 0 && data != NULL);
+    rewind(file);
+    CHECK(fread(data, 1, size, file) == (size_t)size);
+    fclose(file);
+    *length = size;
+
+    return data;
+}
+
+static inline void test_write_file(const char *path, const void *data, size_t length) {
+    FILE *file = fopen(path, "wb");
+
+    CHECK(file != NULL);
+    CHECK(fwrite(data, 1, length, file) == length);
+    CHECK(fclose(file) == 0);
+}
+
+// Bytes allocated through malloc, or 0 where the C library cannot tell
+static inline size_t test_heap_bytes(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+#endif
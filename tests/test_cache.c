@@ -0,0 +1,240 @@
+/*
+    Cache Eviction Tests
+
+    Description:
+    Checks which entry a full `HashCache` evicts. Under LRU, a small scenario pins
+    the order down by hand: gets and overwrites refresh an entry, peeks do not. Then
+    a long random mix of puts, gets, peeks and deletes is replayed against a plain
+    recency list, and every eviction must name that list's oldest entry. Because
+    deletions and evictions shift entries backwards in the slot array, this also
+    checks that the recency list follows the entries it links.
+
+    CLOCK only approximates LRU, so its checks are the guarantees it does give: the
+    only entry not referenced since it was inserted is the one evicted, an entry
+    referenced often outlives unreferenced ones but its counter saturates, so it is
+    evicted within a bounded number of laps once references stop, and a hot set that
+    is referenced between puts survives any amount of cold churn.
+*/
+
+#include <stdint.h>
+
+#include "hashcache.h"
+#include "test.h"
+
+#define TEST_CAPACITY 64
+#define TEST_KEYS 300
+#define TEST_OPS 200000
+
+static char keys[TEST_KEYS][16];
+
+static void put_evicting(HashCache *cache, const char *key, const char *expected) {
+    HashCacheEntry evicted;
+
+    CHECK(ht_cache_put(cache, key, (void *)key, &evicted));
+
+    if(expected) {
+        CHECK(evicted.key != NULL && strcmp(evicted.key, expected) == 0 && evicted.value == (void *)evicted.key);
+    }
+    else {
+        CHECK(evicted.key == NULL);
+    }
+}
+
+static void test_lru_order(void) {
+    HashCache *cache = ht_cache_init(4);
+    void *value;
+
+    put_evicting(cache, "a", NULL);
+    put_evicting(cache, "b", NULL);
+    put_evicting(cache, "c", NULL);
+    put_evicting(cache, "d", NULL);
+
+    // A get refreshes a, so b is the oldest
+    CHECK(ht_cache_get(cache, "a", &value) && value == (void *)"a");
+    put_evicting(cache, "e", "b");
+
+    // A peek leaves c the oldest
+    CHECK(ht_cache_peek(cache, "c", &value));
+    put_evicting(cache, "f", "c");
+
+    // Overwriting refreshes d
+    put_evicting(cache, "d", NULL);
+    put_evicting(cache, "g", "a");
+    put_evicting(cache, "h", "e");
+
+    // A deleted entry is no longer a candidate
+    ht_cache_delete(cache, "f");
+    put_evicting(cache, "i", NULL);
+    put_evicting(cache, "j", "d");
+
+    CHECK(ht_cache_count(cache) == 4);
+    ht_cache_free(&cache);
+}
+
+// Reference model: keys in recency order, least recently used first
+static int model[TEST_CAPACITY];
+static size_t model_count;
+
+static size_t model_find(int key) {
+    for(size_t i = 0; i < model_count; i++) {
+        if(model[i] == key) {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+static void model_remove(size_t position) {
+    memmove(&model[position], &model[position + 1], (model_count - position - 1) * sizeof(int));
+    model_count--;
+}
+
+static void test_lru_model(void) {
+    HashCache *cache = ht_cache_init(TEST_CAPACITY);
+    uint64_t state = 1;
+
+    for(size_t op = 0; op < TEST_OPS; op++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        int key = (int)((state >> 33) % TEST_KEYS);
+        unsigned kind = (unsigned)(state >> 20) % 8;
+        size_t position = model_find(key);
+        void *value = NULL;
+
+        if(kind < 3) {
+            HashCacheEntry evicted;
+
+            CHECK(ht_cache_put(cache, keys[key], keys[key], &evicted));
+
+            if(position != SIZE_MAX) {
+                CHECK(evicted.key == NULL);
+                model_remove(position);
+            }
+            else if(model_count == TEST_CAPACITY) {
+                CHECK(evicted.key == keys[model[0]]);
+                model_remove(0);
+            }
+            else {
+                CHECK(evicted.key == NULL);
+            }
+
+            model[model_count++] = key;
+        }
+        else if(kind < 6) {
+            CHECK(ht_cache_get(cache, keys[key], &value) == (position != SIZE_MAX));
+
+            if(position != SIZE_MAX) {
+                CHECK(value == keys[key]);
+                model_remove(position);
+                model[model_count++] = key;
+            }
+        }
+        else if(kind < 7) {
+            CHECK(ht_cache_peek(cache, keys[key], &value) == (position != SIZE_MAX));
+            CHECK(position == SIZE_MAX || value == keys[key]);
+        }
+        else {
+            ht_cache_delete(cache, keys[key]);
+
+            if(position != SIZE_MAX) {
+                model_remove(position);
+            }
+        }
+
+        CHECK(ht_cache_count(cache) == model_count);
+    }
+
+    ht_cache_free(&cache);
+}
+
+static void fill(HashCache *cache, size_t first, size_t count) {
+    for(size_t i = first; i < first + count; i++) {
+        put_evicting(cache, keys[i], NULL);
+    }
+}
+
+static void test_clock_unreferenced(void) {
+    for(size_t skipped = 0; skipped < 8; skipped++) {
+        HashCache *cache = ht_cache_init_policy(8, HC_POLICY_CLOCK);
+
+        fill(cache, 0, 8);
+
+        for(size_t i = 0; i < 8; i++) {
+            CHECK(i == skipped || ht_cache_get(cache, keys[i], NULL));
+        }
+
+        // A peek is not a reference
+        CHECK(ht_cache_peek(cache, keys[skipped], NULL));
+        put_evicting(cache, keys[8], keys[skipped]);
+        ht_cache_free(&cache);
+    }
+}
+
+static void test_clock_saturation(void) {
+    HashCache *cache = ht_cache_init_policy(4, HC_POLICY_CLOCK);
+    size_t next = 4;
+
+    fill(cache, 0, 4);
+
+    for(int i = 0; i < 10; i++) {
+        CHECK(ht_cache_get(cache, keys[0], NULL));
+    }
+
+    // Unreferenced entries remain, so each eviction's sweep passes keys[0] at most once
+    for(; next < 4 + HC_CLOCK_MAX; next++) {
+        HashCacheEntry evicted;
+
+        CHECK(ht_cache_put(cache, keys[next], keys[next], &evicted));
+        CHECK(evicted.key != NULL && evicted.key != keys[0]);
+    }
+
+    // Ten references count as HC_CLOCK_MAX, so it goes within HC_CLOCK_MAX + 1 laps of the hand
+    while(ht_cache_peek(cache, keys[0], NULL) && next < TEST_KEYS) {
+        CHECK(ht_cache_put(cache, keys[next], keys[next], NULL));
+        next++;
+    }
+
+    CHECK(!ht_cache_peek(cache, keys[0], NULL) && next - 4 <= (HC_CLOCK_MAX + 1) * cache->size);
+    CHECK(ht_cache_count(cache) == 4);
+    ht_cache_free(&cache);
+}
+
+static void test_clock_hot_set(void) {
+    HashCache *cache = ht_cache_init_policy(16, HC_POLICY_CLOCK);
+
+    fill(cache, 0, 16);
+
+    for(size_t i = 16; i < TEST_KEYS; i++) {
+        HashCacheEntry evicted;
+
+        for(size_t hot = 0; hot < 4; hot++) {
+            CHECK(ht_cache_get(cache, keys[hot], NULL));
+        }
+
+        CHECK(ht_cache_put(cache, keys[i], keys[i], &evicted));
+        CHECK(evicted.key != NULL);
+
+        for(size_t hot = 0; hot < 4; hot++) {
+            CHECK(evicted.key != keys[hot]);
+        }
+
+        CHECK(ht_cache_count(cache) == 16);
+    }
+
+    ht_cache_free(&cache);
+}
+
+int main(void) {
+    for(int i = 0; i < TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+    }
+
+    test_lru_order();
+    test_lru_model();
+    test_clock_unreferenced();
+    test_clock_saturation();
+    test_clock_hot_set();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+    Concurrent Hash Table Tests
+
+    Description:
+    Checks that entries survive migrations. Several threads insert, update and delete
+    disjoint keys in a table that starts tiny, so that nearly every write meets a
+    migration in progress, and each thread keeps checking that its earlier keys are
+    still visible. A second test caps the address space in the middle of a migration,
+    so that copies fail to allocate: every write the table accepted must stay readable,
+    and once memory is back the stalled migration must finish. Where the address space
+    cannot be capped, that check is skipped.
+*/
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+#include "hashconcurrent.h"
+#include "test.h"
+
+#define TEST_THREADS 4
+#define TEST_KEYS_PER_THREAD 40000
+#define TEST_OOM_SLOTS (1 << 14)
+#define TEST_OOM_KEYS 200000
+
+static char keys[TEST_THREADS * TEST_KEYS_PER_THREAD][16];
+static char oom_keys[TEST_OOM_KEYS][16];
+static ConcurrentHashTable *shared;
+
+static void *writer(void *arg) {
+    size_t first = (size_t)(uintptr_t)arg * TEST_KEYS_PER_THREAD;
+
+    for(size_t i = 0; i < TEST_KEYS_PER_THREAD; i++) {
+        size_t k = first + i;
+
+        CHECK(ht_concurrent_set(shared, keys[k], (void *)(uintptr_t)k));
+
+        // Earlier keys stay visible, and deleted ones absent, while their slots migrate
+        if(i > 0) {
+            size_t earlier = first + i / 2;
+
+            CHECK(ht_concurrent_has(shared, keys[earlier]) == (earlier % 3 != 0));
+        }
+
+        if(k % 3 == 0) {
+            CHECK(ht_concurrent_set(shared, keys[k], (void *)(uintptr_t)(k + 1)));
+            ht_concurrent_delete(shared, keys[k]);
+        }
+        else if(k % 3 == 1) {
+            CHECK(ht_concurrent_set(shared, keys[k], (void *)(uintptr_t)(k + 1)));
+        }
+    }
+
+    return NULL;
+}
+
+static void test_insert_during_migration(void) {
+    pthread_t threads[TEST_THREADS];
+    size_t live = 0;
+
+    shared = ht_concurrent_init(8);
+    CHECK(shared != NULL);
+
+    for(size_t i = 0; i < TEST_THREADS * TEST_KEYS_PER_THREAD; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%zu", i);
+    }
+
+    for(size_t t = 0; t < TEST_THREADS; t++) {
+        CHECK(pthread_create(&threads[t], NULL, writer, (void *)(uintptr_t)t) == 0);
+    }
+
+    for(size_t t = 0; t < TEST_THREADS; t++) {
+        CHECK(pthread_join(threads[t], NULL) == 0);
+    }
+
+    for(size_t k = 0; k < TEST_THREADS * TEST_KEYS_PER_THREAD; k++) {
+        void *value = NULL;
+        bool found = ht_concurrent_try_get(shared, keys[k], &value);
+
+        if(k % 3 == 0) {
+            CHECK(!found);
+        }
+        else {
+            CHECK(found && value == (void *)(uintptr_t)(k % 3 == 1 ? k + 1 : k));
+            live++;
+        }
+    }
+
+    CHECK(ht_concurrent_count(shared) == live);
+    ht_concurrent_free(&shared);
+}
+
+static size_t mapped_bytes(void) {
+    FILE *file = fopen("/proc/self/statm", "r");
+    size_t pages = 0;
+
+    if(file) {
+        if(fscanf(file, "%zu", &pages) != 1) {
+            pages = 0;
+        }
+
+        fclose(file);
+    }
+
+    return pages * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static void check_inserted(ConcurrentHashTable *ct, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        void *value = NULL;
+
+        CHECK(ht_concurrent_try_get(ct, oom_keys[i], &value) && value == (void *)(uintptr_t)(i + 1));
+    }
+
+    CHECK(ht_concurrent_count(ct) == count);
+}
+
+static void test_failed_copies(void) {
+    ConcurrentHashTable *ct = ht_concurrent_init(TEST_OOM_SLOTS);
+    struct rlimit saved, capped;
+    size_t count = 0;
+
+    CHECK(ct != NULL);
+
+    for(size_t i = 0; i < TEST_OOM_KEYS; i++) {
+        snprintf(oom_keys[i], sizeof(oom_keys[i]), "oom%zu", i);
+    }
+
+    // Fill up to the load factor, so that the next write starts a migration
+    while((float)(count + 1) / (float)TEST_OOM_SLOTS <= 0.7f) {
+        CHECK(ht_concurrent_set(ct, oom_keys[count], (void *)(uintptr_t)(count + 1)));
+        count++;
+    }
+
+    size_t mapped = mapped_bytes();
+
+    CHECK(getrlimit(RLIMIT_AS, &saved) == 0);
+    capped = saved;
+    capped.rlim_cur = mapped + 2 * TEST_OOM_SLOTS * sizeof(HashConcurrentSlot) + (64 << 10); // the next array, little else
+
+    if(mapped == 0 || setrlimit(RLIMIT_AS, &capped) != 0) {
+        puts("address space cannot be capped, failed copy check skipped");
+        ht_concurrent_free(&ct);
+        return;
+    }
+
+    size_t failures = 0;
+
+    for(size_t attempts = 0; attempts < 1000 && failures < 20; attempts++) {
+        if(ht_concurrent_set(ct, oom_keys[count], (void *)(uintptr_t)(count + 1))) {
+            count++;
+        }
+        else {
+            failures++;
+        }
+    }
+
+    // Writes failed, but every accepted one is still readable
+    check_inserted(ct, count);
+    CHECK(setrlimit(RLIMIT_AS, &saved) == 0);
+    CHECK(failures > 0);
+
+    while(count < TEST_OOM_KEYS) {
+        CHECK(ht_concurrent_set(ct, oom_keys[count], (void *)(uintptr_t)(count + 1)));
+        count++;
+    }
+
+    // The stalled migration finished, and later ones grew the table past it
+    CHECK(atomic_load(&ct->top)->size > 2 * TEST_OOM_SLOTS);
+    check_inserted(ct, count);
+    ht_concurrent_free(&ct);
+}
+
+int main(void) {
+    // First, while the heap has no freed memory that copies could still be served from
+    test_failed_copies();
+    test_insert_during_migration();
+
+    return 0;
+}
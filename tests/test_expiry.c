@@ -0,0 +1,131 @@
+/*
+    Expiry Tests
+
+    Description:
+    Checks entries stored with `ht_set_ttl`. Once a tick has reported a time at or
+    past an entry's deadline, lookups treat the entry as absent, even when the tick's
+    budget ran out before it was reaped. A plain `ht_set`, or deleting the key, takes
+    the entry off the wheel. Each `ht_expire_tick` reaps no more than its budget, and
+    repeated ticks reap exactly the entries that are due. Deadlines span several
+    levels of the wheel, so timers are cascaded as well as reaped.
+*/
+
+#include <stdint.h>
+
+#include "hashtable.h"
+#include "test.h"
+
+#define TEST_KEYS 5000
+
+static char keys[TEST_KEYS][16];
+
+// Spread over several wheel levels, with some deadlines shared between keys
+static uint64_t deadline(size_t i) {
+    return 1000 + (i * 7919) % (i % 2 ? 3000000 : 5000);
+}
+
+static void test_deadline(void) {
+    HashTable *ht = ht_init(16);
+
+    CHECK(ht_set_ttl(ht, "early", (void *)1, 100));
+    CHECK(ht_set_ttl(ht, "late", (void *)2, 200));
+    CHECK(ht_set(ht, "plain", (void *)3));
+
+    // Not due yet
+    CHECK(ht_expire_tick(ht, 99, 0) == 0);
+    CHECK(ht_get(ht, "early") == (void *)1 && ht_get(ht, "late") == (void *)2);
+
+    // Due, but not reaped for lack of budget: absent to lookups, still counted
+    CHECK(ht_expire_tick(ht, 100, 0) == 0);
+    CHECK(ht_get(ht, "early") == NULL && !ht_has(ht, "early") && !ht_try_get(ht, "early", NULL));
+    CHECK(ht_get(ht, "late") == (void *)2 && ht_get(ht, "plain") == (void *)3);
+    CHECK(ht_count(ht) == 3);
+
+    CHECK(ht_expire_tick(ht, 100, 10) == 1);
+    CHECK(ht_count(ht) == 2);
+
+    // A tick past every deadline leaves only the plain entry
+    CHECK(ht_expire_tick(ht, 1000, 10) == 1);
+    CHECK(!ht_has(ht, "late") && ht_get(ht, "plain") == (void *)3 && ht_count(ht) == 1);
+
+    // A key that expired can be stored again
+    CHECK(ht_set_ttl(ht, "early", (void *)4, 2000));
+    CHECK(ht_get(ht, "early") == (void *)4);
+    ht_free(&ht);
+}
+
+static void test_persistent_again(void) {
+    HashTable *ht = ht_init(16);
+
+    CHECK(ht_set_ttl(ht, "session", (void *)1, 100));
+    CHECK(ht_set(ht, "session", (void *)2));
+
+    CHECK(ht_set_ttl(ht, "moved", (void *)3, 100));
+    CHECK(ht_set_ttl(ht, "moved", (void *)4, 5000));
+
+    CHECK(ht_set_ttl(ht, "deleted", (void *)5, 100));
+    ht_delete(ht, "deleted");
+
+    // Neither the overwritten nor the deleted entry's old timer fires
+    CHECK(ht_expire_tick(ht, 1000, 100) == 0);
+    CHECK(ht_get(ht, "session") == (void *)2 && ht_get(ht, "moved") == (void *)4);
+    CHECK(!ht_has(ht, "deleted") && ht_count(ht) == 2);
+
+    CHECK(ht_expire_tick(ht, 5000, 100) == 1);
+    CHECK(ht_get(ht, "session") == (void *)2 && !ht_has(ht, "moved"));
+
+    // Persistent for good
+    CHECK(ht_expire_tick(ht, UINT64_MAX, 100) == 0);
+    CHECK(ht_get(ht, "session") == (void *)2);
+    ht_free(&ht);
+}
+
+static void test_budget(void) {
+    HashTable *ht = ht_init(16);
+
+    for(size_t i = 0; i < TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "ttl%zu", i);
+        CHECK(ht_set_ttl(ht, keys[i], (void *)(uintptr_t)(i + 1), deadline(i)));
+    }
+
+    uint64_t checkpoints[] = {999, 1000, 1500, 6000, 100000, 1000000, 3001000};
+    size_t reaped = 0;
+
+    for(size_t c = 0; c < sizeof(checkpoints) / sizeof(checkpoints[0]); c++) {
+        uint64_t now = checkpoints[c];
+        size_t due = 0;
+
+        for(size_t i = 0; i < TEST_KEYS; i++) {
+            due += deadline(i) <= now;
+        }
+
+        // Ticks reap up to their budget until nothing due is left
+        for(;;) {
+            size_t expired = ht_expire_tick(ht, now, 64);
+
+            CHECK(expired <= 64 && expired <= due - reaped);
+            reaped += expired;
+
+            if(expired < 64) {
+                break;
+            }
+        }
+
+        CHECK(reaped == due && ht_count(ht) == TEST_KEYS - due);
+
+        for(size_t i = 0; i < TEST_KEYS; i++) {
+            CHECK(ht_get(ht, keys[i]) == (deadline(i) <= now ? NULL : (void *)(uintptr_t)(i + 1)));
+        }
+    }
+
+    CHECK(ht_count(ht) == 0);
+    ht_free(&ht);
+}
+
+int main(void) {
+    test_deadline();
+    test_persistent_again();
+    test_budget();
+
+    return 0;
+}
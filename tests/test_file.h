@@ -0,0 +1,68 @@
+/*
+    Table File Test Support
+
+    Description:
+    Fixtures shared by the tests that read table files (`ht_load`, `ht_map_open`): a
+    sample file with string keys and values, resealing an image after editing it, and
+    an image whose blob starts past the end of the file with a size that wraps back
+    to it. Include after test.h.
+*/
+
+#ifndef HT_TEST_FILE_H
+#define HT_TEST_FILE_H
+
+#include <stdint.h>
+
+#include "hashsnapshot.h"
+#include "hashtable_internal.h"
+
+#define TEST_FILE_MAX_KEYS 1000
+
+// Keys and values of the sample, "key-<i>" and "value-<i>"; the table does not copy keys
+static char test_file_keys[TEST_FILE_MAX_KEYS][32], test_file_values[TEST_FILE_MAX_KEYS][32];
+
+static inline size_t test_string_size(const void *value) {
+    return strlen((const char *)value) + 1;
+}
+
+// Saves a table of count string entries to path
+static inline void test_save_sample(const char *path, int count) {
+    HashTable *ht = ht_init(0);
+
+    CHECK(ht != NULL && count <= TEST_FILE_MAX_KEYS);
+
+    for(int i = 0; i < count; i++) {
+        snprintf(test_file_keys[i], sizeof(test_file_keys[i]), "key-%d", i);
+        snprintf(test_file_values[i], sizeof(test_file_values[i]), "value-%d", i);
+        CHECK(ht_set(ht, test_file_keys[i], test_file_values[i]));
+    }
+
+    CHECK(ht_save_values(ht, path, test_string_size));
+    ht_free(&ht);
+}
+
+// Recomputes the trailer checksum, so that only the edited fields are wrong
+static inline void test_reseal(unsigned char *data, size_t length) {
+    HashFileTrailer *trailer = (HashFileTrailer *)(data + length - sizeof(HashFileTrailer));
+
+    trailer->checksum = ht_file_checksum(HT_FILE_CHECKSUM_SEED, data, length - sizeof(HashFileTrailer));
+}
+
+// A resealed copy of the image whose blob starts past the end of the file, with a size
+// that wraps back to it, so that offset + size still adds up to the body
+static inline unsigned char *test_wrapped_blob_copy(const unsigned char *data, size_t length) {
+    unsigned char *copy = (unsigned char *)malloc(length);
+    HashFileHeader *header = (HashFileHeader *)copy;
+    uint64_t body = length - sizeof(HashFileTrailer);
+
+    CHECK(copy != NULL);
+    memcpy(copy, data, length);
+    header->blob_offset = (body + 4096) & ~(uint64_t)(HT_FILE_ALIGN - 1);
+    header->blob_size = body - header->blob_offset;
+    CHECK(header->blob_offset + header->blob_size == body);
+    test_reseal(copy, length);
+
+    return copy;
+}
+
+#endif
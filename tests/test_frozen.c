@@ -0,0 +1,192 @@
+/*
+    Frozen Table Tests
+
+    Description:
+    Checks that `ht_freeze` builds a table holding exactly the live entries of its
+    source. Duplicates never reach it twice: keys set repeatedly, deleted and set
+    again, or passed to `ht_build` several times (in the same buffer or in equal
+    copies) each end up in one slot, with the value that won in the source. Empty
+    key sets, whether the table never had entries, lost them all to deletes or had
+    them all expire, freeze into an empty table that answers every lookup with a
+    miss. Key sets of every size up to a few hundred, and a large one, must map each
+    key to a distinct slot and miss on keys that were never inserted.
+*/
+
+#include <stdint.h>
+
+#include "hashfrozen.h"
+#include "test.h"
+
+#define TEST_KEYS 100000
+
+static char keys[TEST_KEYS][16];
+static char copies[TEST_KEYS][16];
+static char misses[1000][16];
+
+// Every source entry present with its value, no other entries, every miss absent
+static void check_frozen(const HashFrozen *frozen, HashTable *source) {
+    CHECK(frozen != NULL && ht_frozen_count(frozen) == ht_count(source));
+
+    // Entries come from the source; with as many as the source has, none is there twice
+    for(size_t i = 0; i < frozen->count; i++) {
+        const HashFrozenEntry *entry = &frozen->entries[i];
+        void *value = NULL;
+
+        CHECK(ht_try_get(source, entry->key, &value) && value == entry->value);
+    }
+
+    for(size_t i = 0; i < source->size; i++) {
+        HashSlot *slot = source->table[i];
+        void *value = NULL;
+
+        if(slot && slot != TOMBSTONE) {
+            CHECK(ht_frozen_try_get(frozen, slot->key, &value) && value == slot->value);
+        }
+    }
+
+    for(size_t i = 0; i < 1000; i++) {
+        CHECK(!ht_frozen_has(frozen, misses[i]) && !ht_frozen_try_get(frozen, misses[i], NULL));
+    }
+}
+
+static void check_empty(HashTable *ht) {
+    HashFrozen *frozen = ht_freeze(ht);
+
+    CHECK(frozen != NULL && ht_frozen_count(frozen) == 0);
+    CHECK(ht_frozen_get(frozen, keys[0]) == NULL && !ht_frozen_has(frozen, misses[0]));
+    CHECK(!ht_frozen_try_get(frozen, keys[0], NULL));
+    ht_frozen_free(&frozen);
+    CHECK(frozen == NULL);
+}
+
+static void test_empty(void) {
+    HashTable *ht = ht_init(16);
+
+    check_empty(ht);
+
+    // Emptied by deletes: only tombstones left
+    for(size_t i = 0; i < 100; i++) {
+        CHECK(ht_set(ht, keys[i], keys[i]));
+    }
+
+    for(size_t i = 0; i < 100; i++) {
+        ht_delete(ht, keys[i]);
+    }
+
+    check_empty(ht);
+    ht_free(&ht);
+
+    // Every entry expired, though none was reaped yet
+    ht = ht_init(16);
+
+    for(size_t i = 0; i < 100; i++) {
+        CHECK(ht_set_ttl(ht, keys[i], keys[i], 10 + i));
+    }
+
+    CHECK(ht_expire_tick(ht, 1000, 0) == 0 && ht_count(ht) == 100);
+    check_empty(ht);
+    ht_free(&ht);
+
+    ht = ht_build(NULL, NULL, 0, 1);
+    CHECK(ht != NULL);
+    check_empty(ht);
+    ht_free(&ht);
+}
+
+static void test_duplicates(void) {
+    // Repeated sets, and deletes followed by sets again
+    HashTable *ht = ht_init(16);
+
+    for(int round = 0; round < 3; round++) {
+        for(size_t i = 0; i < 1000; i++) {
+            CHECK(ht_set(ht, round == 2 ? copies[i] : keys[i], (void *)(uintptr_t)(round * 1000 + i)));
+        }
+
+        for(size_t i = 0; i < 1000; i += 3) {
+            ht_delete(ht, keys[i]);
+        }
+    }
+
+    HashFrozen *frozen = ht_freeze(ht);
+
+    check_frozen(frozen, ht);
+    CHECK(ht_frozen_count(frozen) == 1000 - 334);
+    CHECK(ht_frozen_get(frozen, keys[1]) == (void *)(uintptr_t)2001 && !ht_frozen_has(frozen, keys[3]));
+    ht_frozen_free(&frozen);
+    ht_free(&ht);
+
+    // ht_build with each key three times, the last copy winning
+    const char **build_keys = malloc(3000 * sizeof(char *));
+    void **build_values = malloc(3000 * sizeof(void *));
+
+    CHECK(build_keys != NULL && build_values != NULL);
+
+    for(size_t i = 0; i < 3000; i++) {
+        size_t k = i % 1000;
+
+        build_keys[i] = i < 2000 ? keys[k] : copies[k];
+        build_values[i] = (void *)(uintptr_t)(i + 1);
+    }
+
+    ht = ht_build(build_keys, build_values, 3000, 2);
+    CHECK(ht != NULL && ht_count(ht) == 1000);
+    frozen = ht_freeze(ht);
+    check_frozen(frozen, ht);
+
+    for(size_t k = 0; k < 1000; k++) {
+        CHECK(ht_frozen_get(frozen, keys[k]) == (void *)(uintptr_t)(2000 + k + 1));
+    }
+
+    ht_frozen_free(&frozen);
+    ht_free(&ht);
+    free(build_keys);
+    free(build_values);
+}
+
+static void test_sizes(void) {
+    for(size_t n = 1; n <= 300; n++) {
+        HashTable *ht = ht_init(16);
+
+        for(size_t i = 0; i < n; i++) {
+            CHECK(ht_set(ht, keys[i], (void *)(uintptr_t)(i + 1)));
+        }
+
+        HashFrozen *frozen = ht_freeze(ht);
+
+        check_frozen(frozen, ht);
+        ht_frozen_free(&frozen);
+        ht_free(&ht);
+    }
+
+    HashTable *ht = ht_init(16);
+
+    for(size_t i = 0; i < TEST_KEYS; i++) {
+        CHECK(ht_set(ht, keys[i], NULL));
+    }
+
+    HashFrozen *frozen = ht_freeze(ht);
+
+    check_frozen(frozen, ht);
+
+    // NULL values are stored like any other
+    CHECK(ht_frozen_has(frozen, keys[TEST_KEYS - 1]) && ht_frozen_get(frozen, keys[TEST_KEYS - 1]) == NULL);
+    ht_frozen_free(&frozen);
+    ht_free(&ht);
+}
+
+int main(void) {
+    for(size_t i = 0; i < TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%zu", i);
+        strcpy(copies[i], keys[i]);
+    }
+
+    for(size_t i = 0; i < 1000; i++) {
+        snprintf(misses[i], sizeof(misses[i]), "miss%zu", i);
+    }
+
+    test_empty();
+    test_duplicates();
+    test_sizes();
+
+    return 0;
+}
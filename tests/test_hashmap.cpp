@@ -0,0 +1,305 @@
+/*
+    C++ Hash Map Tests
+
+    Description:
+    Checks `ht::hash_map` where its own memory is at stake: insertions whose arguments
+    refer to entries of the map while it grows, value constructors that throw during
+    an insertion, a copy or a resize, and an allocator that must get back everything
+    it handed out. Live values are registered and allocated bytes counted, so leaks, double
+    destruction and copies from destroyed values are caught without a sanitizer.
+*/
+
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+#include "hashtable.hpp"
+#include "test.h"
+
+static std::unordered_set<const void *> live_values;
+static long copies_left = -1; // copies before the next one throws; -1 never throws
+static long moves_left = -1;  // same for moves of Fragile
+static long allocated_bytes = 0;
+
+struct Tracked {
+    std::string text;
+
+    explicit Tracked(std::string value) : text(std::move(value)) {
+        live_values.insert(this);
+    }
+
+    Tracked(const Tracked &other) : text(live(other).text) {
+        if(copies_left == 0) {
+            throw std::runtime_error("copy failed");
+        }
+
+        copies_left -= copies_left > 0;
+        live_values.insert(this);
+    }
+
+    Tracked(Tracked &&other) noexcept : text(std::move(live(other).text)) {
+        live_values.insert(this);
+    }
+
+    ~Tracked() {
+        CHECK(live_values.erase(this) == 1);
+    }
+
+    static Tracked &live(const Tracked &value) {
+        CHECK(live_values.count(&value) == 1);
+
+        return const_cast<Tracked &>(value);
+    }
+};
+
+// Move-only, with a move constructor that may throw, so a resize has to move it anyway
+struct Fragile {
+    Tracked value;
+
+    explicit Fragile(std::string text) : value(std::move(text)) {}
+
+    Fragile(const Fragile &) = delete;
+
+    Fragile(Fragile &&other) noexcept(false) : value(std::move(other.value)) {
+        if(moves_left == 0) {
+            throw std::runtime_error("move failed");
+        }
+
+        moves_left -= moves_left > 0;
+    }
+};
+
+template<class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template<class U>
+    CountingAllocator(const CountingAllocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        allocated_bytes += static_cast<long>(n * sizeof(T));
+
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        allocated_bytes -= static_cast<long>(n * sizeof(T));
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    friend bool operator==(const CountingAllocator &, const CountingAllocator &) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(const CountingAllocator &, const CountingAllocator &) noexcept {
+        return false;
+    }
+};
+
+using TrackedMap = ht::hash_map<std::string, Tracked, ht::hash<std::string>, std::equal_to<>,
+                                CountingAllocator<std::pair<const std::string, Tracked>>>;
+
+using FragileMap = ht::hash_map<std::string, Fragile, ht::hash<std::string>, std::equal_to<>,
+                                CountingAllocator<std::pair<const std::string, Fragile>>>;
+
+static std::string long_text(int i) {
+    return "value number " + std::to_string(i) + " long enough to live on the heap";
+}
+
+// Every insertion takes its arguments from the map, across several resizes
+static void test_aliasing_arguments() {
+    ht::hash_map<std::string, std::string> map;
+
+    map.try_emplace("key0", long_text(0));
+
+    for(int i = 1; i < 200; i++) {
+        const std::string &previous = map.at("key" + std::to_string(i - 1));
+
+        map.emplace("key" + std::to_string(i), previous);
+        CHECK(map.at("key" + std::to_string(i)) == long_text(0));
+
+        // Key and value both refer to an entry
+        map.try_emplace(map.at("key0"), map.at("key0"));
+        CHECK(map.size() == static_cast<size_t>(i + 2));
+        CHECK(map.at(long_text(0)) == long_text(0));
+        map.erase(long_text(0));
+    }
+
+    // Each key is the value of the entry before it
+    ht::hash_map<std::string, std::string> chain;
+
+    chain.try_emplace(long_text(0), long_text(1));
+
+    for(int i = 1; i <= 100; i++) {
+        chain.try_emplace(chain.at(long_text(i - 1)), long_text(i + 1));
+        CHECK(chain.at(long_text(i)) == long_text(i + 1));
+    }
+
+    CHECK(chain.size() == 101);
+
+    // Copies from a destroyed value are caught even when the memory still looks right
+    {
+        TrackedMap tracked;
+
+        tracked.try_emplace("key0", long_text(0));
+
+        for(int i = 1; i < 200; i++) {
+            tracked.try_emplace("key" + std::to_string(i), tracked.at("key" + std::to_string(i - 1)));
+        }
+
+        CHECK(tracked.at("key199").text == long_text(0));
+    }
+
+    CHECK(live_values.empty() && allocated_bytes == 0);
+}
+
+// A value constructor that throws while the map grows leaves the map as it was
+static void test_throwing_insert() {
+    {
+        TrackedMap map;
+        Tracked prototype(long_text(-1));
+
+        // Filled so that the next insertion grows the map
+        map.reserve(20);
+
+        for(int i = 0; (map.size() + 1) * 10 <= map.capacity() * 7; i++) {
+            map.try_emplace("key" + std::to_string(i), long_text(i));
+        }
+
+        size_t size = map.size();
+        size_t capacity = map.capacity();
+
+        copies_left = 0;
+
+        try {
+            map.try_emplace("new", prototype);
+            CHECK(false);
+        }
+        catch(const std::runtime_error &) {
+        }
+
+        copies_left = -1;
+        CHECK(map.size() == size && map.capacity() == capacity && !map.contains("new"));
+
+        for(size_t i = 0; i < size; i++) {
+            CHECK(map.at("key" + std::to_string(i)).text == long_text(static_cast<int>(i)));
+        }
+
+        CHECK(live_values.size() == size + 1);
+    }
+
+    CHECK(live_values.empty() && allocated_bytes == 0);
+}
+
+// A copy that throws part-way releases what it had copied
+static void test_throwing_copy() {
+    {
+        TrackedMap map;
+
+        for(int i = 0; i < 100; i++) {
+            map.try_emplace("key" + std::to_string(i), long_text(i));
+        }
+
+        long before = allocated_bytes;
+
+        for(long limit = 0; limit < 100; limit += 7) {
+            copies_left = limit;
+
+            try {
+                TrackedMap copy(map, map.get_allocator());
+                CHECK(false);
+            }
+            catch(const std::runtime_error &) {
+            }
+
+            copies_left = limit;
+
+            try {
+                TrackedMap copy(map);
+                CHECK(false);
+            }
+            catch(const std::runtime_error &) {
+            }
+
+            copies_left = -1;
+            CHECK(live_values.size() == 100 && allocated_bytes == before);
+        }
+
+        TrackedMap copy(map);
+
+        CHECK(copy.size() == 100 && copy.at("key42").text == long_text(42));
+    }
+
+    CHECK(live_values.empty() && allocated_bytes == 0);
+}
+
+// A value move that throws part-way through a resize keeps what was moved and frees the rest
+static void test_throwing_resize() {
+    for(long limit = 0; limit < 20; limit += 4) {
+        {
+            FragileMap map;
+
+            map.reserve(20);
+
+            for(int i = 0; (map.size() + 1) * 10 <= map.capacity() * 7; i++) {
+                map.try_emplace("key" + std::to_string(i), long_text(i));
+            }
+
+            size_t size = map.size();
+
+            CHECK(size > static_cast<size_t>(limit));
+            moves_left = limit;
+
+            try {
+                map.try_emplace("new", long_text(-1));
+                CHECK(false);
+            }
+            catch(const std::runtime_error &) {
+            }
+
+            moves_left = -1;
+
+            // The new entry and those moved before the failure, nothing else
+            size_t found = 0;
+
+            for(const auto &entry : map) {
+                CHECK(entry.first == "new" || entry.second.value.text == long_text(std::stoi(entry.first.substr(3))));
+                found++;
+            }
+
+            CHECK(found == map.size() && map.size() == static_cast<size_t>(limit) + 1 && map.size() <= size);
+            CHECK(map.contains("new") && live_values.size() == map.size());
+
+            // The map keeps working
+            for(int i = 0; i < 100; i++) {
+                map.try_emplace("more" + std::to_string(i), long_text(i));
+            }
+
+            CHECK(map.size() == static_cast<size_t>(limit) + 101 && live_values.size() == map.size());
+        }
+
+        CHECK(live_values.empty() && allocated_bytes == 0);
+    }
+
+    // A pair whose key is const is inserted by copying the key
+    {
+        FragileMap map;
+        std::pair<const std::string, Fragile> entry(long_text(1), Fragile(long_text(2)));
+
+        map.insert(std::move(entry));
+        CHECK(entry.first == long_text(1) && map.at(long_text(1)).value.text == long_text(2));
+    }
+
+    CHECK(live_values.empty() && allocated_bytes == 0);
+}
+
+int main() {
+    test_aliasing_arguments();
+    test_throwing_insert();
+    test_throwing_copy();
+    test_throwing_resize();
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+    Memory-Mapped Table Tests
+
+    Description:
+    Opens saved tables with `ht_map_open` and checks lookups, then checks that files
+    with inconsistent offsets are either rejected when opened or answer lookups
+    without reading outside the mapping, and that `ht_map_verify` catches damage.
+*/
+
+#include "hashmapped.h"
+#include "test.h"
+#include "test_file.h"
+
+#define TEST_KEYS 500
+
+static void test_lookups(const char *path) {
+    MappedHashTable *mht = ht_map_open(path);
+    const void *value;
+    size_t length;
+
+    CHECK(mht != NULL);
+    CHECK(ht_map_verify(mht));
+    CHECK(ht_map_count(mht) == TEST_KEYS);
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        CHECK(ht_map_try_get(mht, test_file_keys[i], &value, &length));
+        CHECK(length == strlen(test_file_values[i]) + 1 && strcmp(value, test_file_values[i]) == 0);
+    }
+
+    CHECK(!ht_map_has(mht, "key-missing"));
+    ht_map_close(&mht);
+    CHECK(mht == NULL);
+}
+
+static void test_wrapped_blob(const char *path, const unsigned char *data, size_t length) {
+    unsigned char *copy = test_wrapped_blob_copy(data, length);
+
+    test_write_file(path, copy, length);
+    CHECK(ht_map_open(path) == NULL);
+
+    test_write_file(path, data, length / 2);
+    CHECK(ht_map_open(path) == NULL);
+
+    free(copy);
+}
+
+// Entries pointing outside the blob: opening does not read them, lookups must not follow them
+static void test_bad_entries(const char *path, const unsigned char *data, size_t length) {
+    unsigned char *copy = malloc(length);
+    const HashFileHeader *header = (const HashFileHeader *)copy;
+
+    memcpy(copy, data, length);
+
+    HashFileEntry *entries = (HashFileEntry *)(copy + header->entries_offset);
+
+    for(uint64_t i = 0; i < header->count; i++) {
+        if(i % 2) {
+            entries[i].key_offset = UINT64_MAX - 2;
+        }
+        else {
+            entries[i].value_offset = header->blob_size;
+            entries[i].value_length = 1;
+        }
+    }
+
+    test_write_file(path, copy, length);
+
+    MappedHashTable *mht = ht_map_open(path);
+    const void *value;
+    size_t value_length;
+    size_t found = 0;
+
+    CHECK(mht != NULL);
+    CHECK(!ht_map_verify(mht));
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        if(ht_map_try_get(mht, test_file_keys[i], &value, &value_length)) {
+            CHECK(value == NULL && value_length == 0);
+            found++;
+        }
+    }
+
+    CHECK(found > 0 && found < TEST_KEYS);
+    ht_map_close(&mht);
+    free(copy);
+}
+
+int main(void) {
+    char path[32];
+    size_t length;
+
+    test_temp_path(path);
+    test_save_sample(path, TEST_KEYS);
+    test_lookups(path);
+
+    unsigned char *data = test_read_file(path, &length);
+
+    test_wrapped_blob(path, data, length);
+    test_bad_entries(path, data, length);
+
+    free(data);
+    unlink(path);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+    Snapshot Publication Tests
+
+    Description:
+    Checks that a reader holding a snapshot keeps it valid across publishes, and that
+    replaced tables are freed promptly instead of accumulating: with no reader active,
+    each `ht_publish` frees the table it replaces, and `ht_publish_sync` frees every
+    retired table once the readers are gone. Memory is tracked through the heap in use;
+    where the C library cannot report it, only the correctness checks run. Concurrent
+    readers also run against a publishing writer.
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "hashpublish.h"
+#include "test.h"
+
+#define TEST_KEYS 256
+#define TEST_SLOTS (1 << 16)
+#define TEST_TABLE_BYTES (TEST_SLOTS * sizeof(HashSlot *))
+#define TEST_VERSIONS 200
+
+static char keys[TEST_KEYS][16];
+
+// Every table holds all keys mapped to the same version number
+static HashTable *make_version(size_t version) {
+    HashTable *ht = ht_init(TEST_SLOTS);
+
+    CHECK(ht != NULL);
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        CHECK(ht_set(ht, keys[i], (void *)(uintptr_t)(version + 1)));
+    }
+
+    return ht;
+}
+
+static void test_eager_release(void) {
+    HashPublisher *pub = ht_publisher_init(make_version(0));
+
+    CHECK(pub != NULL);
+    CHECK(ht_publish(pub, make_version(1)));
+
+    size_t baseline = test_heap_bytes();
+
+    for(size_t version = 2; version <= 12; version++) {
+        CHECK(ht_publish(pub, make_version(version)));
+        CHECK(ht_published_get(pub, keys[0]) == (void *)(uintptr_t)(version + 1));
+
+        // The replaced table was freed before ht_publish returned
+        CHECK(test_heap_bytes() < baseline + TEST_TABLE_BYTES / 2);
+    }
+
+    ht_publisher_free(&pub);
+}
+
+static void test_reader_keeps_snapshot(void) {
+    HashPublisher *pub = ht_publisher_init(make_version(0));
+    size_t baseline = test_heap_bytes();
+    HashTable *snapshot = ht_snapshot_acquire(pub);
+
+    // The held snapshot is replaced twice but must stay readable
+    CHECK(ht_publish(pub, make_version(1)));
+    CHECK(ht_publish(pub, make_version(2)));
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        CHECK(ht_get(snapshot, keys[i]) == (void *)(uintptr_t)1);
+    }
+
+    CHECK(test_heap_bytes() >= baseline + (baseline ? 2 * TEST_TABLE_BYTES : 0));
+    ht_snapshot_release(pub);
+
+    // Nothing retired is left behind once the reader is gone
+    CHECK(ht_publish_sync(pub, make_version(3)));
+    CHECK(ht_published_get(pub, keys[0]) == (void *)(uintptr_t)4);
+    CHECK(test_heap_bytes() < baseline + TEST_TABLE_BYTES / 2);
+    ht_publisher_free(&pub);
+}
+
+typedef struct {
+    HashPublisher *pub;
+    _Atomic bool stop;
+} ReaderJob;
+
+static void *reader(void *arg) {
+    ReaderJob *job = arg;
+    uintptr_t last = 0;
+
+    while(!atomic_load(&job->stop)) {
+        HashTable *snapshot = ht_snapshot_acquire(job->pub);
+        uintptr_t version = (uintptr_t)ht_get(snapshot, keys[0]);
+
+        // A snapshot is consistent and versions never go backwards
+        for(int i = 0; i < TEST_KEYS; i += 17) {
+            CHECK((uintptr_t)ht_get(snapshot, keys[i]) == version);
+        }
+
+        CHECK(version >= last);
+        last = version;
+        ht_snapshot_release(job->pub);
+    }
+
+    return NULL;
+}
+
+static void test_concurrent_readers(void) {
+    ReaderJob job = {ht_publisher_init(make_version(0)), false};
+    size_t baseline = test_heap_bytes();
+    pthread_t threads[4];
+
+    for(int i = 0; i < 4; i++) {
+        CHECK(pthread_create(&threads[i], NULL, reader, &job) == 0);
+    }
+
+    for(size_t version = 1; version <= TEST_VERSIONS; version++) {
+        CHECK(ht_publish(job.pub, make_version(version)));
+    }
+
+    atomic_store(&job.stop, true);
+
+    for(int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CHECK(ht_publish_sync(job.pub, make_version(TEST_VERSIONS + 1)));
+    CHECK(test_heap_bytes() < baseline + TEST_TABLE_BYTES / 2 + 64 * 1024);
+    ht_publisher_free(&job.pub);
+}
+
+int main(void) {
+    for(int i = 0; i < TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "route-%d", i);
+    }
+
+    test_eager_release();
+    test_reader_keeps_snapshot();
+    test_concurrent_readers();
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+    NUMA Replica Tests
+
+    Description:
+    Checks that a table bound to a node takes its slots from node memory rather than
+    the heap, and that replicas never disagree about a key. The replicated table here
+    is built by hand with three replicas bound to node 0, so that key copies and
+    rollback run on any machine. A write is made to fail part-way through by capping
+    the address space just before the replicas need new arena chunks: the first
+    replica gets its chunk and applies the write, the second cannot, and the first
+    must be rolled back. Where the address space cannot be capped, that check is
+    skipped.
+*/
+
+#include <stdint.h>
+#include <sys/resource.h>
+
+#include "hashreplica.h"
+#include "test.h"
+
+#define TEST_REPLICAS 3
+#define TEST_SLOTS (1 << 17)
+#define TEST_MAX_KEYS 100000
+
+static void test_bound_slots(void) {
+    HashTable *ht = ht_init_numa(TEST_SLOTS, HT_NUMA_BIND, 0);
+    static char keys[10000][24];
+
+    CHECK(ht != NULL);
+
+    size_t baseline = test_heap_bytes();
+
+    for(int i = 0; i < 10000; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "bound%d", i);
+        CHECK(ht_set(ht, keys[i], (void *)(uintptr_t)(i + 1)));
+    }
+
+    // Slots come from the node arena, not the heap
+    CHECK(test_heap_bytes() < baseline + 10000 * sizeof(HashSlot) / 4);
+
+    for(int i = 0; i < 10000; i += 2) {
+        ht_delete(ht, keys[i]);
+    }
+
+    for(int i = 0; i < 10000; i++) {
+        CHECK(ht_get(ht, keys[i]) == (i % 2 ? (void *)(uintptr_t)(i + 1) : NULL));
+    }
+
+    ht_free(&ht);
+}
+
+static ReplicatedHashTable *make_replicated(void) {
+    ReplicatedHashTable *rht = malloc(sizeof(ReplicatedHashTable));
+
+    CHECK(rht != NULL);
+    rht->replica_count = TEST_REPLICAS;
+    rht->replicas = calloc(TEST_REPLICAS, sizeof(HashTable *));
+    CHECK(rht->replicas != NULL);
+
+    for(int i = 0; i < TEST_REPLICAS; i++) {
+        rht->replicas[i] = ht_init_numa(TEST_SLOTS, HT_NUMA_BIND, 0);
+        CHECK(rht->replicas[i] != NULL);
+    }
+
+    return rht;
+}
+
+static void check_agree(ReplicatedHashTable *rht, size_t count) {
+    char key[32];
+
+    for(int r = 0; r < TEST_REPLICAS; r++) {
+        CHECK(ht_count(rht->replicas[r]) == count);
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+
+        for(int r = 0; r < TEST_REPLICAS; r++) {
+            CHECK(ht_get(rht->replicas[r], key) == (void *)(uintptr_t)(i + 1));
+        }
+    }
+}
+
+static void test_key_copies(void) {
+    ReplicatedHashTable *rht = make_replicated();
+    char key[32];
+
+    // Keys are copied, so the caller's buffer can be reused
+    for(size_t i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        CHECK(ht_replicated_set(rht, key, (void *)(uintptr_t)i));
+    }
+
+    for(size_t i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        CHECK(ht_replicated_set(rht, key, (void *)(uintptr_t)(i + 1)));
+    }
+
+    check_agree(rht, 1000);
+
+    for(size_t i = 500; i < 1000; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        ht_replicated_delete(rht, key);
+    }
+
+    check_agree(rht, 500);
+    CHECK(!ht_replicated_set(rht, "", NULL));
+    check_agree(rht, 500);
+    ht_replicated_free(&rht);
+}
+
+static size_t mapped_bytes(void) {
+    FILE *file = fopen("/proc/self/statm", "r");
+    size_t pages = 0;
+
+    if(file) {
+        if(fscanf(file, "%zu", &pages) != 1) {
+            pages = 0;
+        }
+
+        fclose(file);
+    }
+
+    return pages * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static void test_rollback(void) {
+    ReplicatedHashTable *rht = make_replicated();
+    struct rlimit saved, capped;
+    char key[32];
+
+    // The first write maps every replica's first arena chunk
+    CHECK(ht_replicated_set(rht, "k0", (void *)1));
+
+    size_t mapped = mapped_bytes();
+
+    CHECK(getrlimit(RLIMIT_AS, &saved) == 0);
+    capped = saved;
+    capped.rlim_cur = mapped + (3 << 19); // room for one more 1 MiB chunk, not two
+
+    if(mapped == 0 || setrlimit(RLIMIT_AS, &capped) != 0) {
+        puts("address space cannot be capped, rollback check skipped");
+        ht_replicated_free(&rht);
+        return;
+    }
+
+    size_t count = 1;
+
+    while(count < TEST_MAX_KEYS) {
+        snprintf(key, sizeof(key), "k%zu", count);
+
+        if(!ht_replicated_set(rht, key, (void *)(uintptr_t)(count + 1))) {
+            break;
+        }
+
+        count++;
+    }
+
+    CHECK(setrlimit(RLIMIT_AS, &saved) == 0);
+    CHECK(count < TEST_MAX_KEYS);
+
+    // The failed key is in no replica and everything before it is in all of them
+    for(int r = 0; r < TEST_REPLICAS; r++) {
+        CHECK(!ht_has(rht->replicas[r], key));
+    }
+
+    check_agree(rht, count);
+
+    // With memory back, the same write succeeds everywhere
+    CHECK(ht_replicated_set(rht, key, (void *)(uintptr_t)(count + 1)));
+    check_agree(rht, count + 1);
+    ht_replicated_free(&rht);
+}
+
+int main(void) {
+    test_bound_slots();
+    test_key_copies();
+    test_rollback();
+
+    return 0;
+}
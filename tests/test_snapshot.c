@@ -0,0 +1,99 @@
+/*
+    Snapshot Tests
+
+    Description:
+    Round-trips a table through `ht_save_values` and `ht_load`, and checks that damaged
+    files are rejected: truncated files, flipped bytes, and headers whose section
+    offsets are inconsistent even though their checksum has been recomputed.
+*/
+
+#include "test.h"
+#include "test_file.h"
+
+#define TEST_KEYS 1000
+
+static void test_round_trip(const char *path) {
+    char key[32], value[32];
+    HashTable *ht = ht_load(path);
+
+    CHECK(ht != NULL);
+    CHECK(ht_count(ht) == TEST_KEYS);
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key-%d", i);
+        snprintf(value, sizeof(value), "value-%d", i);
+        CHECK(ht_get(ht, key) != NULL && strcmp(ht_get(ht, key), value) == 0);
+    }
+
+    CHECK(!ht_has(ht, "key-missing"));
+    ht_free(&ht);
+}
+
+static void test_truncated(const char *path, const unsigned char *data, size_t length) {
+    size_t cuts[] = {0, 8, sizeof(HashFileHeader) - 1, sizeof(HashFileHeader) + sizeof(HashFileTrailer), length / 2,
+                     length - sizeof(HashFileTrailer), length - 1};
+
+    for(size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        test_write_file(path, data, cuts[i]);
+        CHECK(ht_load(path) == NULL);
+    }
+}
+
+static void test_flipped_byte(const char *path, const unsigned char *data, size_t length) {
+    unsigned char *copy = malloc(length);
+    const HashFileHeader *header = (const HashFileHeader *)data;
+    size_t positions[] = {0, sizeof(HashFileHeader) + 3, header->entries_offset + 5, header->blob_offset + 1,
+                          length - 1};
+
+    for(size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++) {
+        memcpy(copy, data, length);
+        copy[positions[i]] ^= 0x40;
+        test_write_file(path, copy, length);
+        CHECK(ht_load(path) == NULL);
+    }
+
+    free(copy);
+}
+
+static void test_wrapped_blob(const char *path, const unsigned char *data, size_t length) {
+    unsigned char *copy = test_wrapped_blob_copy(data, length);
+    HashFileHeader *header = (HashFileHeader *)copy;
+
+    test_write_file(path, copy, length);
+    CHECK(ht_load(path) == NULL);
+    CHECK(ht_file_validate(copy, length, true) == NULL);
+
+    // Sections overlapping each other or the header
+    memcpy(copy, data, length);
+    header->entries_offset = UINT64_MAX & ~(uint64_t)7;
+    test_reseal(copy, length);
+    CHECK(ht_file_validate(copy, length, true) == NULL);
+
+    memcpy(copy, data, length);
+    header->count = header->size + 1;
+    test_reseal(copy, length);
+    CHECK(ht_file_validate(copy, length, true) == NULL);
+
+    free(copy);
+}
+
+int main(void) {
+    char path[32];
+    size_t length;
+
+    test_temp_path(path);
+    test_save_sample(path, TEST_KEYS);
+    test_round_trip(path);
+
+    unsigned char *data = test_read_file(path, &length);
+
+    CHECK(ht_file_validate(data, length, true) != NULL);
+    test_truncated(path, data, length);
+    test_flipped_byte(path, data, length);
+    test_wrapped_blob(path, data, length);
+
+    free(data);
+    unlink(path);
+
+    return 0;
+}
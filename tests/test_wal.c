@@ -0,0 +1,183 @@
+/*
+    Write-Ahead Log Tests
+
+    Description:
+    Checks what a log brings back after a crash. Sets, overwrites and deletes are
+    replayed in order, so deleted keys stay deleted. A log cut anywhere inside its
+    last record, as a crash in the middle of a write leaves it, or with a damaged
+    last record, replays every record before it and nothing after. Opening such a
+    log for appending cuts the damaged tail off, so records written afterwards are
+    replayed rather than hidden behind it.
+*/
+
+#include <stdint.h>
+
+#include "hashwal.h"
+#include "test.h"
+
+#define TEST_KEYS 200
+
+static char keys[TEST_KEYS + 1][16];
+static char values[TEST_KEYS + 1][32];
+
+// Logs a set of every key, overwrites every third one and deletes every fifth one
+static void write_log(const char *path) {
+    HashWal *wal = ht_wal_open(path, HT_WAL_SYNC_COMMIT, 0, NULL);
+    HashTable *ht = ht_init(16);
+
+    CHECK(wal != NULL && ht != NULL);
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        CHECK(ht_wal_set(wal, ht, keys[i], "first"));
+    }
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        if(i % 3 == 0) {
+            CHECK(ht_wal_set(wal, ht, keys[i], values[i]));
+        }
+
+        if(i % 5 == 0) {
+            CHECK(ht_wal_delete(wal, ht, keys[i]));
+        }
+    }
+
+    CHECK(ht_wal_commit(wal));
+    ht_wal_close(&wal);
+    ht_free(&ht);
+}
+
+static void check_logged(HashTable *ht) {
+    size_t live = 0;
+
+    for(int i = 0; i < TEST_KEYS; i++) {
+        void *value = NULL;
+        bool found = ht_try_get(ht, keys[i], &value);
+
+        if(i % 5 == 0) {
+            CHECK(!found);
+            continue;
+        }
+
+        CHECK(found && strcmp(value, i % 3 == 0 ? values[i] : "first") == 0);
+        live++;
+    }
+
+    CHECK(ht_count(ht) == live);
+}
+
+static void test_replay(void) {
+    char path[32];
+
+    test_temp_path(path);
+    write_log(path);
+
+    HashTable *ht = ht_wal_recover(NULL, path);
+
+    CHECK(ht != NULL);
+    check_logged(ht);
+    ht_free(&ht);
+    unlink(path);
+}
+
+// Appends one more set to the log and returns the file lengths before and after it
+static void append_last(const char *path, size_t *before, size_t *after) {
+    size_t length;
+
+    free(test_read_file(path, before));
+
+    HashWal *wal = ht_wal_open(path, HT_WAL_SYNC_COMMIT, 0, NULL);
+    HashTable *ht = ht_init(16);
+
+    CHECK(wal != NULL && ht != NULL);
+    CHECK(ht_wal_set(wal, ht, keys[TEST_KEYS], values[TEST_KEYS]));
+    ht_wal_close(&wal);
+    ht_free(&ht);
+    free(test_read_file(path, &length));
+    CHECK(length > *before);
+    *after = length;
+}
+
+static void check_recovered(const char *path, bool has_last) {
+    HashTable *ht = ht_wal_recover(NULL, path);
+
+    CHECK(ht != NULL);
+    CHECK(ht_has(ht, keys[TEST_KEYS]) == has_last);
+
+    if(has_last) {
+        CHECK(strcmp(ht_get(ht, keys[TEST_KEYS]), values[TEST_KEYS]) == 0);
+        ht_delete(ht, keys[TEST_KEYS]);
+    }
+
+    check_logged(ht);
+    ht_free(&ht);
+}
+
+static void test_torn_tail(void) {
+    char path[32], cut_path[32];
+    size_t before, after, length;
+
+    test_temp_path(path);
+    test_temp_path(cut_path);
+    write_log(path);
+    append_last(path, &before, &after);
+
+    unsigned char *data = test_read_file(path, &length);
+
+    CHECK(length == after);
+    check_recovered(path, true);
+
+    // Cut at every byte of the last record
+    for(size_t cut = before; cut < after; cut++) {
+        test_write_file(cut_path, data, cut);
+        check_recovered(cut_path, false);
+    }
+
+    // Whole, but with one byte of the last record damaged
+    for(size_t offset = before; offset < after; offset += 3) {
+        data[offset] ^= 0x20;
+        test_write_file(cut_path, data, after);
+        check_recovered(cut_path, false);
+        data[offset] ^= 0x20;
+    }
+
+    free(data);
+    unlink(path);
+    unlink(cut_path);
+}
+
+static void test_append_after_torn_tail(void) {
+    char path[32];
+    size_t before, after, length;
+
+    test_temp_path(path);
+    write_log(path);
+    append_last(path, &before, &after);
+
+    unsigned char *data = test_read_file(path, &length);
+
+    // A crash wrote half of the last record
+    test_write_file(path, data, before + (after - before) / 2);
+    free(data);
+
+    // Opening cuts the half record off, so the same record appended again lands where it belongs
+    size_t cut_before, cut_after;
+
+    append_last(path, &cut_before, &cut_after);
+    CHECK(cut_before == before + (after - before) / 2);
+    CHECK(cut_after == after);
+    check_recovered(path, true);
+    unlink(path);
+}
+
+int main(void) {
+    for(int i = 0; i <= TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+        snprintf(values[i], sizeof(values[i]), "value of key %d", i);
+    }
+
+    test_replay();
+    test_torn_tail();
+    test_append_after_torn_tail();
+
+    return 0;
+}